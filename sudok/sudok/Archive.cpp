@@ -0,0 +1,565 @@
+#include "stdafx.h"
+#include "Archive.h"
+#include "BlockCompressor.h"
+#include "PuzzleFile.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace KSudoku {
+
+    const unsigned char ARCHIVE_MAGIC[4] = { 'K', 'S', 'D', 'A' };
+    const int ARCHIVE_VERSION = 1;
+    const int ARCHIVE_FLAG_COMPRESSED = 1;
+    const int ARCHIVE_INDEX_ENTRY_SIZE = 16;
+    const int ARCHIVE_BITMAP_SIZE = 11;             // 81 bits
+    const unsigned int SOLUTION_EMPTY = 0xFFFF;     // the first word of a grid which isn't full
+
+    inline void PutU16(unsigned char* p, unsigned int v)
+    {
+        p[0] = (unsigned char)v;
+        p[1] = (unsigned char)(v >> 8);
+    }
+
+    inline void PutU32(unsigned char* p, unsigned int v)
+    {
+        for (int k = 0; k < 4; k++)
+            p[k] = (unsigned char)(v >> (8 * k));
+    }
+
+    inline void PutU64(unsigned char* p, unsigned long long v)
+    {
+        for (int k = 0; k < 8; k++)
+            p[k] = (unsigned char)(v >> (8 * k));
+    }
+
+    inline unsigned int GetU16(const unsigned char* p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    inline unsigned int GetU32(const unsigned char* p)
+    {
+        unsigned int v = 0;
+        for (int k = 3; k >= 0; k--)
+            v = (v << 8) | p[k];
+        return v;
+    }
+
+    inline unsigned long long GetU64(const unsigned char* p)
+    {
+        unsigned long long v = 0;
+        for (int k = 7; k >= 0; k--)
+            v = (v << 8) | p[k];
+        return v;
+    }
+
+    // appends a puzzle record: the bitmap of the given cells, then their digits two to a byte
+    void EncodePuzzle(const char cells[81], std::vector<unsigned char>& out)
+    {
+        size_t nBitmap = out.size();
+        out.resize(nBitmap + ARCHIVE_BITMAP_SIZE, 0);
+
+        int nGiven = 0;
+        unsigned char pending = 0;
+        for (int n = 0; n < 81; n++)
+        {
+            if (cells[n] == 0)
+                continue;
+
+            out[nBitmap + n / 8] |= (unsigned char)(1 << (n % 8));
+            if (nGiven % 2 == 0)
+                pending = (unsigned char)cells[n];
+            else
+                out.push_back((unsigned char)(pending | (cells[n] << 4)));
+            nGiven++;
+        }
+        if (nGiven % 2 == 1)
+            out.push_back(pending);
+    }
+
+    // decodes a puzzle record, returns its size or 0 if it runs past the end or isn't sound
+    size_t DecodePuzzle(const unsigned char* p, const unsigned char* end, char cells[81])
+    {
+        if (end - p < ARCHIVE_BITMAP_SIZE || (p[ARCHIVE_BITMAP_SIZE - 1] >> 1) != 0)
+            return 0;
+
+        const unsigned char* digits = p + ARCHIVE_BITMAP_SIZE;
+        int nGiven = 0;
+        for (int n = 0; n < 81; n++)
+        {
+            if (!(p[n / 8] & (1 << (n % 8))))
+            {
+                cells[n] = 0;
+                continue;
+            }
+
+            if (digits + nGiven / 2 >= end)
+                return 0;
+            int digit = nGiven % 2 == 0 ? digits[nGiven / 2] & 0x0F : digits[nGiven / 2] >> 4;
+            if (digit < 1 || digit > 9)
+                return 0;
+            cells[n] = (char)digit;
+            nGiven++;
+        }
+
+        return ARCHIVE_BITMAP_SIZE + (nGiven + 1) / 2;
+    }
+
+    // writes a solution record: the digits - 1 in base 9, five to a 16 bit word, and the last
+    // one in a byte of its own
+    void EncodeSolution(const char cells[81], unsigned char out[ARCHIVE_SOLUTION_SIZE])
+    {
+        for (int n = 0; n < 81; n++)
+        {
+            if (cells[n] < 1 || cells[n] > 9)
+            {
+                memset(out, 0, ARCHIVE_SOLUTION_SIZE);
+                PutU16(out, SOLUTION_EMPTY);
+                return;
+            }
+        }
+
+        for (int w = 0; w < 16; w++)
+        {
+            unsigned int v = 0;
+            for (int k = 4; k >= 0; k--)
+                v = v * 9 + (cells[w * 5 + k] - 1);
+            PutU16(out + w * 2, v);
+        }
+        out[32] = (unsigned char)(cells[80] - 1);
+    }
+
+    bool DecodeSolution(const unsigned char in[ARCHIVE_SOLUTION_SIZE], char cells[81])
+    {
+        if (GetU16(in) == SOLUTION_EMPTY)
+        {
+            memset(cells, 0, 81);
+            return true;
+        }
+
+        for (int w = 0; w < 16; w++)
+        {
+            unsigned int v = GetU16(in + w * 2);
+            if (v >= 9 * 9 * 9 * 9 * 9)
+                return false;
+            for (int k = 0; k < 5; k++)
+            {
+                cells[w * 5 + k] = (char)(v % 9 + 1);
+                v /= 9;
+            }
+        }
+        if (in[32] > 8)
+            return false;
+        cells[80] = (char)(in[32] + 1);
+
+        return true;
+    }
+
+    bool IsArchiveFileName(const char* fileName)
+    {
+        size_t n = fileName ? strlen(fileName) : 0;
+        return n >= 4 && strcmp(fileName + n - 4, ".ksa") == 0;
+    }
+
+    bool IsArchive(const char* begin, const char* end)
+    {
+        return end - begin >= ARCHIVE_HEADER_SIZE && memcmp(begin, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0;
+    }
+
+    ArchiveWriter::ArchiveWriter()
+        : m_file(nullptr), m_kind(ARCHIVE_PUZZLES), m_bCompress(false), m_bFailed(false),
+          m_nRecords(0), m_nOffset(0), m_nInBlock(0)
+    {
+    }
+
+    ArchiveWriter::~ArchiveWriter()
+    {
+        if (m_file)
+            close();
+    }
+
+    bool ArchiveWriter::open(const char* fileName, ArchiveKind kind, bool bCompress)
+    {
+        m_file = fopen(fileName, "wb");
+        if (!m_file)
+            return false;
+
+        m_kind = kind;
+        m_bCompress = bCompress;
+        m_bFailed = false;
+        m_nRecords = 0;
+        m_nInBlock = 0;
+        m_block.clear();
+        m_block.reserve(ARCHIVE_BLOCK_RECORDS * ARCHIVE_MAX_RECORD_SIZE);
+        m_index.clear();
+
+        // the counts aren't known yet, close() writes the header again
+        m_nOffset = ARCHIVE_HEADER_SIZE;
+        return writeHeader();
+    }
+
+    bool ArchiveWriter::write(const char cells[81])
+    {
+        if (m_kind == ARCHIVE_PUZZLES)
+        {
+            EncodePuzzle(cells, m_block);
+        }
+        else
+        {
+            size_t n = m_block.size();
+            m_block.resize(n + ARCHIVE_SOLUTION_SIZE);
+            EncodeSolution(cells, &m_block[n]);
+        }
+        m_nRecords++;
+
+        if (++m_nInBlock == ARCHIVE_BLOCK_RECORDS)
+            return flushBlock();
+        return !m_bFailed;
+    }
+
+    bool ArchiveWriter::flushBlock()
+    {
+        if (m_nInBlock == 0)
+            return !m_bFailed;
+
+        size_t nRaw = m_block.size();
+        const unsigned char* pStored = &m_block[0];
+        size_t nStored = nRaw;
+        if (m_bCompress)
+        {
+            m_compressed.resize(CompressBound(nRaw));
+            size_t n = CompressBlock(&m_block[0], nRaw, &m_compressed[0], m_compressed.size());
+            if (n > 0 && n < nRaw)
+            {
+                pStored = &m_compressed[0];
+                nStored = n;
+            }
+        }
+
+        if (fwrite(pStored, 1, nStored, m_file) != nStored)
+            m_bFailed = true;
+
+        m_index.push_back((unsigned long long)m_nOffset);
+        m_index.push_back(nStored);
+        m_index.push_back(nRaw);
+        m_nOffset += nStored;
+
+        m_block.clear();
+        m_nInBlock = 0;
+        return !m_bFailed;
+    }
+
+    bool ArchiveWriter::writeHeader()
+    {
+        unsigned long long nBlocks = m_index.size() / 3;
+
+        unsigned char header[ARCHIVE_HEADER_SIZE] = {};
+        memcpy(header, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        PutU16(header + 4, ARCHIVE_VERSION);
+        header[6] = (unsigned char)m_kind;
+        header[7] = (unsigned char)(m_bCompress ? ARCHIVE_FLAG_COMPRESSED : 0);
+        PutU32(header + 8, ARCHIVE_BLOCK_RECORDS);
+        PutU32(header + 12, (unsigned int)nBlocks);
+        PutU64(header + 16, (unsigned long long)m_nRecords);
+        PutU64(header + 24, (unsigned long long)m_nOffset);    // the index follows the last block
+
+        if (fseek(m_file, 0, SEEK_SET) != 0 || fwrite(header, 1, sizeof(header), m_file) != sizeof(header))
+            m_bFailed = true;
+        return !m_bFailed;
+    }
+
+    bool ArchiveWriter::close()
+    {
+        if (!m_file)
+            return false;
+
+        flushBlock();
+
+        unsigned char entry[ARCHIVE_INDEX_ENTRY_SIZE];
+        for (size_t k = 0; k < m_index.size(); k += 3)
+        {
+            PutU64(entry, m_index[k]);
+            PutU32(entry + 8, (unsigned int)m_index[k + 1]);
+            PutU32(entry + 12, (unsigned int)m_index[k + 2]);
+            if (fwrite(entry, 1, sizeof(entry), m_file) != sizeof(entry))
+                m_bFailed = true;
+        }
+
+        writeHeader();
+        if (fclose(m_file) != 0)
+            m_bFailed = true;
+        m_file = nullptr;
+
+        return !m_bFailed;
+    }
+
+    ArchiveReader::ArchiveReader()
+        : m_pData(nullptr), m_nSize(0), m_pError(nullptr), m_kind(ARCHIVE_PUZZLES), m_bCompressed(false),
+          m_nBlockRecords(0), m_nRecords(0), m_nBlocks(0), m_pIndex(nullptr),
+          m_nNext(0), m_nBlock(0), m_nInBlock(0), m_nBlockSize(0)
+    {
+    }
+
+    // Everything next() and readBlock() rely on is checked here: the header, and that every
+    // block of the index lies between the header and the index.
+    //
+    bool ArchiveReader::attach(const char* begin, const char* end)
+    {
+        m_pData = (const unsigned char*)begin;
+        m_nSize = (size_t)(end - begin);
+        m_nNext = 0;
+        m_nBlock = 0;
+        m_nInBlock = 0;
+        m_nBlockSize = 0;
+
+        if (!IsArchive(begin, end))
+        {
+            m_pError = "not an archive";
+            return false;
+        }
+
+        const unsigned char* header = m_pData;
+        if (GetU16(header + 4) != ARCHIVE_VERSION || header[6] > ARCHIVE_SOLUTIONS)
+        {
+            m_pError = "an archive of an unknown version or kind";
+            return false;
+        }
+
+        m_kind = (ArchiveKind)header[6];
+        m_bCompressed = (header[7] & ARCHIVE_FLAG_COMPRESSED) != 0;
+        unsigned int nBlockRecords = GetU32(header + 8);
+        unsigned int nBlocks = GetU32(header + 12);
+        unsigned long long nRecords = GetU64(header + 16);
+        unsigned long long nIndex = GetU64(header + 24);
+
+        if (nBlockRecords == 0 || nBlockRecords > (1 << 20)
+            || nBlocks != (nRecords + nBlockRecords - 1) / nBlockRecords
+            || nIndex < (unsigned long long)ARCHIVE_HEADER_SIZE || nIndex > m_nSize
+            || (m_nSize - nIndex) / ARCHIVE_INDEX_ENTRY_SIZE < nBlocks)
+        {
+            m_pError = "the header doesn't match the size of the archive";
+            return false;
+        }
+
+        m_nBlockRecords = (int)nBlockRecords;
+        m_nBlocks = (int)nBlocks;
+        m_nRecords = (long long)nRecords;
+        m_pIndex = m_pData + nIndex;
+
+        for (int b = 0; b < m_nBlocks; b++)
+        {
+            const unsigned char* entry = m_pIndex + b * ARCHIVE_INDEX_ENTRY_SIZE;
+            unsigned long long nOffset = GetU64(entry);
+            unsigned long long nStored = GetU32(entry + 8);
+            if (nOffset < (unsigned long long)ARCHIVE_HEADER_SIZE || nOffset > nIndex || nStored > nIndex - nOffset)
+            {
+                m_pError = "a block lies outside of the archive";
+                return false;
+            }
+        }
+
+        m_pError = nullptr;
+        return true;
+    }
+
+    int ArchiveReader::readBlock(int nBlock, std::vector<unsigned char>& scratch, char* cells) const
+    {
+        if (nBlock < 0 || nBlock >= m_nBlocks)
+            return -1;
+
+        const unsigned char* entry = m_pIndex + nBlock * ARCHIVE_INDEX_ENTRY_SIZE;
+        const unsigned char* p = m_pData + GetU64(entry);
+        size_t nStored = GetU32(entry + 8);
+        size_t nRaw = GetU32(entry + 12);
+        long long nLeft = m_nRecords - (long long)nBlock * m_nBlockRecords;
+        int nRecords = nLeft < m_nBlockRecords ? (int)nLeft : m_nBlockRecords;
+
+        // a block which didn't shrink is stored as it is
+        if (nStored != nRaw)
+        {
+            if (nRaw > (size_t)nRecords * ARCHIVE_MAX_RECORD_SIZE)
+                return -1;
+            scratch.resize(nRaw);
+            if (DecompressBlock(p, nStored, &scratch[0], nRaw) != (long long)nRaw)
+                return -1;
+            p = &scratch[0];
+        }
+
+        const unsigned char* end = p + nRaw;
+        for (int k = 0; k < nRecords; k++)
+        {
+            if (m_kind == ARCHIVE_PUZZLES)
+            {
+                size_t n = DecodePuzzle(p, end, cells + k * 81);
+                if (n == 0)
+                    return -1;
+                p += n;
+            }
+            else
+            {
+                if (end - p < ARCHIVE_SOLUTION_SIZE || !DecodeSolution(p, cells + k * 81))
+                    return -1;
+                p += ARCHIVE_SOLUTION_SIZE;
+            }
+        }
+
+        return p == end ? nRecords : -1;
+    }
+
+    bool ArchiveReader::next(char cells[81])
+    {
+        if (m_nInBlock == m_nBlockSize)
+        {
+            if (m_nBlock == m_nBlocks)
+                return false;
+
+            m_cells.resize((size_t)m_nBlockRecords * 81);
+            m_nBlockSize = readBlock(m_nBlock, m_scratch, &m_cells[0]);
+            if (m_nBlockSize < 0)
+            {
+                m_pError = "a corrupt block";
+                m_nBlock = m_nBlocks;
+                m_nBlockSize = 0;
+                m_nInBlock = 0;
+                return false;
+            }
+            m_nBlock++;
+            m_nInBlock = 0;
+        }
+
+        memcpy(cells, &m_cells[m_nInBlock * 81], 81);
+        m_nInBlock++;
+        m_nNext++;
+        return true;
+    }
+
+    int PackArchive(const char* inputFileName, const char* outputFileName, ArchiveKind kind, bool bCompress)
+    {
+        MappedFile input;
+        if (!input.open(inputFileName))
+        {
+            fprintf(stderr, "can't open %s\n", inputFileName);
+            return -1;
+        }
+
+        ArchiveWriter writer;
+        if (!writer.open(outputFileName, kind, bCompress))
+        {
+            fprintf(stderr, "can't open %s\n", outputFileName);
+            return -1;
+        }
+
+        PuzzleParser parser(input.begin(), input.end());
+        char cells[81];
+        long long nEmpty = 0;
+        ParseResult result;
+        while ((result = parser.next(cells)) != PARSE_END)
+        {
+            if (result == PARSE_MALFORMED)
+            {
+                if (kind == ARCHIVE_PUZZLES)
+                {
+                    fprintf(stderr, "line %lld, offset %lld: invalid puzzle, %s, skipped\n",
+                        parser.recordLine(), parser.recordOffset(), parser.error());
+                    continue;
+                }
+
+                // "no solution" or "invalid" of the batch mode
+                memset(cells, 0, sizeof(cells));
+                nEmpty++;
+            }
+            if (!writer.write(cells))
+            {
+                writer.close();
+                fprintf(stderr, "can't write %s\n", outputFileName);
+                return -1;
+            }
+        }
+
+        long long nRecords = writer.size();
+        if (!writer.close())
+        {
+            fprintf(stderr, "can't write %s\n", outputFileName);
+            return -1;
+        }
+
+        FILE* output = fopen(outputFileName, "rb");
+        long long nBytes = 0;
+        if (output)
+        {
+            fseek(output, 0, SEEK_END);
+            nBytes = ftell(output);
+            fclose(output);
+        }
+        fprintf(stderr, "%lld records (%lld empty), %lld bytes from %lld, %.1f bytes per record\n",
+            nRecords, nEmpty, nBytes, (long long)input.size(), nRecords > 0 ? (double)nBytes / nRecords : 0.0);
+
+        return 0;
+    }
+
+    int UnpackArchive(const char* inputFileName, const char* outputFileName)
+    {
+        MappedFile input;
+        if (!input.open(inputFileName))
+        {
+            fprintf(stderr, "can't open %s\n", inputFileName);
+            return -1;
+        }
+
+        ArchiveReader reader;
+        if (!reader.attach(input.begin(), input.end()))
+        {
+            fprintf(stderr, "%s: %s\n", inputFileName, reader.error());
+            return -1;
+        }
+
+        FILE* output = stdout;
+        if (outputFileName)
+        {
+            output = fopen(outputFileName, "w");
+            if (!output)
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+        }
+        setvbuf(output, NULL, _IOFBF, 1 << 16);
+
+        std::vector<unsigned char> scratch;
+        std::vector<char> cells((size_t)reader.blockRecords() * 81);
+        char line[82];
+        line[81] = '\n';
+        int nResult = 0;
+        for (int b = 0; b < reader.blockCount() && nResult == 0; b++)
+        {
+            int nRecords = reader.readBlock(b, scratch, &cells[0]);
+            if (nRecords < 0)
+            {
+                fprintf(stderr, "%s: block %d is corrupt\n", inputFileName, b);
+                nResult = -1;
+                break;
+            }
+
+            for (int k = 0; k < nRecords; k++)
+            {
+                const char* grid = &cells[k * 81];
+                if (reader.kind() == ARCHIVE_SOLUTIONS && grid[0] == 0)
+                {
+                    fputs("no solution\n", output);
+                    continue;
+                }
+                for (int n = 0; n < 81; n++)
+                    line[n] = grid[n] == 0 ? '.' : (char)('0' + grid[n]);
+                fwrite(line, 1, sizeof(line), output);
+            }
+        }
+
+        if (output != stdout)
+            fclose(output);
+        else
+            fflush(output);
+
+        return nResult;
+    }
+
+}
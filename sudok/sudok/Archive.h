@@ -0,0 +1,118 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+
+namespace KSudoku {
+
+    // A binary file of puzzles or solutions, a few times smaller than the text formats and cut
+    // into blocks which can be read independently of each other:
+    //
+    //   header      "KSDA", version, kind, flags, records per block, record and block counts,
+    //               the offset of the index, 40 bytes little endian
+    //   blocks      the records of each block back to back, compressed if the archive is
+    //   index       per block its offset in the file, its stored size and its raw size
+    //
+    // A puzzle record is an 81 bit bitmap of the given cells followed by their digits, 4 bits
+    // each, 20 bytes for a 17 clue puzzle. A solution record packs the digits in base 9, five to
+    // 16 bits, 33 bytes per grid; a grid which isn't full (no solution) is kept as an empty grid.
+    // Every block but the last holds the same number of records, so record k is found from the
+    // index alone and a job can be split over threads by blocks.
+
+    enum ArchiveKind {
+        ARCHIVE_PUZZLES,
+        ARCHIVE_SOLUTIONS
+    };
+
+    const int ARCHIVE_HEADER_SIZE = 40;
+    const int ARCHIVE_BLOCK_RECORDS = 4096;
+    const int ARCHIVE_SOLUTION_SIZE = 33;
+    const int ARCHIVE_MAX_RECORD_SIZE = 11 + 41;        // a puzzle with every cell given
+
+    // true if the file name ends with ".ksa", the files the tools write as archives
+    bool IsArchiveFileName(const char* fileName);
+
+    // true if the buffer starts like an archive
+    bool IsArchive(const char* begin, const char* end);
+
+    // Writes the records one at a time, a block is encoded when it is full. The header is written
+    // again with the counts by close(), so the file must be seekable.
+    class ArchiveWriter {
+    public:
+        ArchiveWriter();
+        ~ArchiveWriter();
+
+        bool        open(const char* fileName, ArchiveKind kind, bool bCompress);
+        bool        write(const char cells[81]);    // the cells 0 ~ 9 row by row
+        bool        close();                        // false if anything failed to be written
+
+        long long   size() const    { return m_nRecords; }
+
+    private:
+        ArchiveWriter(const ArchiveWriter&);
+        ArchiveWriter& operator=(const ArchiveWriter&);
+
+        bool        flushBlock();
+        bool        writeHeader();
+
+    private:
+        FILE*                           m_file;
+        ArchiveKind                     m_kind;
+        bool                            m_bCompress;
+        bool                            m_bFailed;
+        long long                       m_nRecords;
+        long long                       m_nOffset;          // where the next block goes
+        int                             m_nInBlock;
+        std::vector<unsigned char>      m_block;
+        std::vector<unsigned char>      m_compressed;
+        std::vector<unsigned long long> m_index;            // 3 values per block
+    };
+
+    // Reads an archive in a buffer, usually a MappedFile. readBlock() is const and decodes into
+    // the caller's buffers, so any number of threads can read blocks of the same archive.
+    class ArchiveReader {
+    public:
+        ArchiveReader();
+
+        bool        attach(const char* begin, const char* end);     // false if it isn't a sound archive
+        const char* error() const       { return m_pError; }
+
+        ArchiveKind kind() const        { return m_kind; }
+        bool        isCompressed() const { return m_bCompressed; }
+        long long   size() const        { return m_nRecords; }
+        int         blockCount() const  { return m_nBlocks; }
+        int         blockRecords() const { return m_nBlockRecords; }
+
+        // decodes the records of a block into cells, 81 per record, and returns their count,
+        // or -1 if the block is corrupt. scratch holds the decompressed block if it needs one.
+        int         readBlock(int nBlock, std::vector<unsigned char>& scratch, char* cells) const;
+
+        // the records one after another, like a PuzzleParser
+        bool        next(char cells[81]);
+        long long   recordIndex() const { return m_nNext - 1; }     // of the last record, from 0
+
+    private:
+        const unsigned char*    m_pData;
+        size_t                  m_nSize;
+        const char*             m_pError;
+        ArchiveKind             m_kind;
+        bool                    m_bCompressed;
+        int                     m_nBlockRecords;
+        long long               m_nRecords;
+        int                     m_nBlocks;
+        const unsigned char*    m_pIndex;
+
+        // the block being read by next()
+        long long               m_nNext;
+        int                     m_nBlock;
+        int                     m_nInBlock;
+        int                     m_nBlockSize;
+        std::vector<unsigned char>  m_scratch;
+        std::vector<char>           m_cells;
+    };
+
+    // Converts a text file of puzzles, or of solutions, to an archive and back. Packing skips
+    // the malformed puzzles, a line which isn't a full grid in a solutions file becomes an empty
+    // grid so the solutions stay in line with their puzzles. Both return -1 on failure.
+    int PackArchive(const char* inputFileName, const char* outputFileName, ArchiveKind kind, bool bCompress);
+    int UnpackArchive(const char* inputFileName, const char* outputFileName);
+}
@@ -1,10 +1,12 @@
 #include "stdafx.h"
-#include "Table.h"
+#include "Board.h"
 #include "BackTracking.h"
+#include "SearchBudget.h"
+#include "SearchStats.h"
 
 namespace KSudoku {
 
-    bool ProcessCell(Table& table, Cell& cell);
+    bool ProcessCell(Board& board, int n, SearchBudget* pBudget, SearchStats& stats);
 
     // Algorithm:
     //
@@ -17,65 +19,69 @@ namespace KSudoku {
     //
     // The idea is that we can always meet the chance of all the numbers in each cell(step) are filling right.
     //
-    bool SolveByBackTracking(Table& table) {
-        bool b = ProcessCell(table, table.getFirstCell());
+    // Every number tried spends a node of the budget, once it runs out each cell gives up in turn.
+    //
+    bool SearchBackTracking(Board& board, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        PhaseTimer timer(pStats, PHASE_SEARCH);
+        SearchStats stats;
+        bool b = ProcessCell(board, 0, pBudget, stats);
         if (b)
         {
-            b = table.veifyAll();
+            b = VerifySolution(board);
         }
 
-        if (b)
-        {
-            printf("we find a solutions!\n");
-            table.print();
-        }
-        else
+        if (pStats)
+            pStats->add(stats);
+        return b;
+    }
+
+    // no other cell of the row/column/sub-region of cell n holds v
+    bool VerifyCell(const Board& board, int n, int v)
+    {
+        const unsigned char* peers = BOARD_UNITS.peers[n];
+        for (int k = 0; k < 20; k++)
         {
-            printf("we don't find a solution\n");
+            if (board.value(peers[k]) == v)
+                return false;
         }
 
-        return b;
+        return true;
     }
 
-    bool ProcessCell(Table& table, Cell& cell) {
-        if (cell.isConst())
+    bool ProcessCell(Board& board, int n, SearchBudget* pBudget, SearchStats& stats) {
+        if (board.isGiven(n))
         {
-            if (table.hasNextCell(cell))
+            if (n + 1 < Board::CELLS)
             {
-                Cell& nextCell = table.getNextCell(cell);
-                return ProcessCell(table, nextCell);
+                return ProcessCell(board, n + 1, pBudget, stats);
             }
             else
             {
-                return table.verifyCell(cell);
+                KSUDOKU_COUNT(stats.nValidations++);
+                return VerifyCell(board, n, board.value(n));
             }
         }
-        else {
-            bool bCurrentValueValid = false;
-            while (!bCurrentValueValid)
-            {
-                bCurrentValueValid = cell.increaseValue();
-                if (!bCurrentValueValid)        // we exhaust all the numbers in this cell
-                    break;
 
-                bCurrentValueValid = table.verifyCell(cell);
-                if (bCurrentValueValid)
-                {
-                    if (table.hasNextCell(cell))
-                    {
-                        Cell& nextCell = table.getNextCell(cell);
-                        bCurrentValueValid = ProcessCell(table, nextCell);
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
+        // a number is verified before it is placed, the board's masks only ever hold legal ones
+        for (int v = 1; v <= 9; v++)
+        {
+            if (pBudget && pBudget->spend())
+                return false;
 
+            KSUDOKU_COUNT(stats.nNodes++);
+            KSUDOKU_COUNT(stats.nValidations++);
+            if (VerifyCell(board, n, v))
+            {
+                board.place(n, v);
+                if (n + 1 == Board::CELLS || ProcessCell(board, n + 1, pBudget, stats))
+                    return true;
+                board.remove(n);
             }
-
-            return bCurrentValueValid;
+            KSUDOKU_COUNT(stats.nBacktracks++);
         }
+
+        return false;       // we exhaust all the numbers in this cell
     }
 
-}
\ No newline at end of file
+}
@@ -1,7 +1,12 @@
 #pragma once
 
 namespace KSudoku {
-    class Table;
+    template <int BoxSize> class BasicBoard;
+    typedef BasicBoard<3> Board;
+    struct SearchStats;
+    class SearchBudget;
 
-    bool SolveByBackTracking(Table& table);
+    // fills the board without printing, false if there is no solution or the budget ran out,
+    // pBudget and pStats may be NULL
+    bool SearchBackTracking(Board& board, SearchBudget* pBudget, SearchStats* pStats);
 }
@@ -0,0 +1,121 @@
+#pragma once
+#include <string.h>
+#include <type_traits>
+#include "DigitMask.h"
+
+namespace KSudoku {
+
+    // A compact board of any sudoku size, made of BoxSize x BoxSize sub-regions: 9x9 for 3,
+    // 16x16 for 4, 25x25 for 5. It holds the values row by row, a bitmap of the given cells and
+    // the digit masks of every row, column and sub-region. All the sizes are compile time
+    // constants, so the loops over a unit or over the board have fixed bounds and the index math
+    // turns into constant multiplies.
+    //
+    // It has no pointers, so copying a board is a memcpy, cheap enough to hand a board to each
+    // branch of a parallel search.
+    //
+    template <int BoxSize>
+    class BasicBoard {
+    public:
+        static const int SIZE = BoxSize * BoxSize;     // digits, and cells in a unit
+        static const int CELLS = SIZE * SIZE;
+        static const int UNITS = 3 * SIZE;              // the rows, then the columns, then the sub-regions
+
+        // bit (v - 1) stands for digit v, 16 bits are enough up to 16x16
+        typedef typename std::conditional<(SIZE <= 16), unsigned short, unsigned int>::type Mask;
+
+        static const Mask ALL = (Mask)((1u << SIZE) - 1);
+
+        BasicBoard() { clear(); }
+
+        void        clear()                     { memset(this, 0, sizeof(BasicBoard)); }
+
+        static constexpr int rowOf(int n)       { return n / SIZE; }
+        static constexpr int columnOf(int n)    { return n % SIZE; }
+        static constexpr int boxOf(int n)       { return n / (SIZE * BoxSize) * BoxSize + n % SIZE / BoxSize; }
+        static constexpr Mask maskOf(int v)     { return (Mask)(1u << (v - 1)); }
+
+        // the k-th cell of a unit, the rows left to right, the columns top down and the
+        // sub-regions row by row
+        static constexpr int unitCell(int nUnit, int k)
+        {
+            return nUnit < SIZE ? nUnit * SIZE + k
+                 : nUnit < 2 * SIZE ? k * SIZE + nUnit - SIZE
+                 : ((nUnit - 2 * SIZE) / BoxSize * BoxSize + k / BoxSize) * SIZE
+                   + (nUnit - 2 * SIZE) % BoxSize * BoxSize + k % BoxSize;
+        }
+
+        int         value(int n) const          { return mValues[n]; }
+        const unsigned char* values() const     { return mValues; }
+        bool        isGiven(int n) const        { return (mGiven[n / 8] >> (n % 8)) & 1; }
+
+        Mask        candidates(int n) const
+        {
+            Mask used = mRowMask[rowOf(n)] | mColumnMask[columnOf(n)] | mBoxMask[boxOf(n)];
+            return (Mask)(~used & ALL);
+        }
+
+        void        place(int n, int v)
+        {
+            Mask bit = maskOf(v);
+            mRowMask[rowOf(n)] |= bit;
+            mColumnMask[columnOf(n)] |= bit;
+            mBoxMask[boxOf(n)] |= bit;
+            mValues[n] = (unsigned char)v;
+        }
+
+        // a given cell, or one the singles forced, which the searches leave alone
+        void        placeGiven(int n, int v)
+        {
+            place(n, v);
+            mGiven[n / 8] |= (unsigned char)(1 << (n % 8));
+        }
+
+        void        remove(int n)
+        {
+            Mask bit = maskOf(mValues[n]);
+            mRowMask[rowOf(n)] &= (Mask)~bit;
+            mColumnMask[columnOf(n)] &= (Mask)~bit;
+            mBoxMask[boxOf(n)] &= (Mask)~bit;
+            mValues[n] = 0;
+        }
+
+    private:
+        unsigned char   mValues[CELLS];         // 0 for null cells
+        unsigned char   mGiven[(CELLS + 7) / 8];
+        Mask            mRowMask[SIZE];
+        Mask            mColumnMask[SIZE];
+        Mask            mBoxMask[SIZE];
+    };
+
+    // Checks that every row, column and sub-region of a full board holds each digit once.
+    // The units of the cells are ORed together in one pass over the board.
+    //
+    template <int BoxSize>
+    bool VerifyBoard(const BasicBoard<BoxSize>& board)
+    {
+        typedef BasicBoard<BoxSize> B;
+        typename B::Mask rows[B::SIZE] = {};
+        typename B::Mask columns[B::SIZE] = {};
+        typename B::Mask boxes[B::SIZE] = {};
+
+        for (int n = 0; n < B::CELLS; n++)
+        {
+            int v = board.value(n);
+            if (v < 1 || v > B::SIZE)
+                return false;
+
+            typename B::Mask bit = B::maskOf(v);
+            rows[B::rowOf(n)] |= bit;
+            columns[B::columnOf(n)] |= bit;
+            boxes[B::boxOf(n)] |= bit;
+        }
+
+        typename B::Mask all = B::ALL;
+        for (int k = 0; k < B::SIZE; k++)
+            all &= rows[k] & columns[k] & boxes[k];
+
+        return all == B::ALL;
+    }
+
+}
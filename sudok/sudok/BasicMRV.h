@@ -0,0 +1,182 @@
+#pragma once
+#include <utility>
+#include "BasicBoard.h"
+#include "SearchBudget.h"
+#include "SearchStats.h"
+
+namespace KSudoku {
+
+    // The minimum remaining values search of MRV.cpp for a board of any size: always fill the open
+    // cell with the fewest candidates, keeping each filled cell with its untried candidates on a
+    // fixed size trail. The search runs in place on the board and stops at each solution, with
+    // the board holding it; the next call goes on with the next candidate of the last cell. So
+    // walking all the solutions takes no more than the trail, however many there are.
+    //
+    template <int BoxSize>
+    class BasicMRVSearch {
+    public:
+        typedef BasicBoard<BoxSize>     B;
+        typedef typename B::Mask        Mask;
+
+        explicit BasicMRVSearch(B& board) : m_board(board)  { reset(); }
+
+        // starts over from the cells of the board as they are now
+        void reset()
+        {
+            m_nOpen = 0;
+            for (int n = 0; n < B::CELLS; n++)
+            {
+                if (m_board.value(n) == 0)
+                    m_openCells[m_nOpen++] = n;
+            }
+            m_depth = 0;
+            m_bSolved = false;
+            m_bDone = false;
+            m_bStopped = false;
+        }
+
+        // Goes on to the next solution and leaves it on the board, false once the tree is
+        // exhausted or the budget runs out, pBudget may be NULL for none. What the search did is
+        // added to pStats unless it is NULL.
+        bool next(SearchBudget* pBudget, SearchStats* pStats);
+
+        bool stopped() const    { return m_bStopped; }
+
+    private:
+        struct TrailEntry {
+            int     nCell;
+            Mask    remaining;
+        };
+
+        B&          m_board;
+        int         m_openCells[B::CELLS];  // those in front of m_depth are filled, those behind are still open
+        int         m_nOpen;
+        TrailEntry  m_trail[B::CELLS];
+        int         m_depth;
+        bool        m_bSolved;              // the board holds the solution returned last
+        bool        m_bDone;
+        bool        m_bStopped;
+    };
+
+    template <int BoxSize>
+    bool BasicMRVSearch<BoxSize>::next(SearchBudget* pBudget, SearchStats* pStats)
+    {
+        if (m_bDone)
+            return false;
+
+        // kept in locals for the loop, the board's byte stores could alias the members
+        B& board = m_board;
+        TrailEntry* trail = m_trail;
+        int* openCells = m_openCells;
+        int nOpen = m_nOpen;
+        int depth = m_depth;
+        bool bSolved = m_bSolved;
+        SearchStats stats;
+
+        for (;;)
+        {
+            if (bSolved)
+            {
+                // go on from the last cell of the solution before
+                bSolved = false;
+                if (depth == 0)
+                {
+                    m_bDone = true;
+                    break;
+                }
+
+                depth--;
+                board.remove(trail[depth].nCell);
+                KSUDOKU_COUNT(stats.nBacktracks++);
+            }
+            else if (depth < nOpen)
+            {
+                // choose the most constrained open cell and move it to the front of the open cells
+                int best = depth;
+                int bestCount = B::SIZE + 1;
+                Mask bestMask = 0;
+                for (int k = depth; k < nOpen; k++)
+                {
+                    Mask mask = board.candidates(openCells[k]);
+                    int count = CountDigits(mask);
+                    if (count < bestCount)
+                    {
+                        best = k;
+                        bestCount = count;
+                        bestMask = mask;
+                        if (count <= 1)
+                            break;
+                    }
+                }
+                std::swap(openCells[depth], openCells[best]);
+                trail[depth].nCell = openCells[depth];
+                trail[depth].remaining = bestMask;
+                KSUDOKU_COUNT(stats.nBranches++);
+                KSUDOKU_COUNT(stats.nCandidates += bestCount);
+            }
+            else
+            {
+                bSolved = true;     // all cells are filled
+                break;
+            }
+
+            // take the next candidate, going back along the trail while a cell has none left
+            while (trail[depth].remaining == 0 && depth > 0)
+            {
+                depth--;
+                board.remove(trail[depth].nCell);
+                KSUDOKU_COUNT(stats.nBacktracks++);
+            }
+            if (trail[depth].remaining == 0)
+            {
+                m_bDone = true;     // we exhaust all the candidates of the first cell
+                break;
+            }
+
+            if (pBudget && pBudget->spend())
+            {
+                m_bDone = true;
+                m_bStopped = true;
+                break;
+            }
+
+            TrailEntry& entry = trail[depth];
+            board.place(entry.nCell, LowestDigit(entry.remaining));
+            entry.remaining &= entry.remaining - 1;
+            depth++;
+            KSUDOKU_COUNT(stats.nNodes++);
+        }
+
+        m_depth = depth;
+        m_bSolved = bSolved;
+        if (pStats)
+            pStats->add(stats);
+        return bSolved;
+    }
+
+    // Counts the solutions of the board up to nLimit, the board is left holding the last one if
+    // nLimit was reached. If the budget runs out the search gives up and returns 0. What the
+    // search did is added to pStats unless it is NULL.
+    //
+    template <int BoxSize>
+    int CountBoardSolutions(BasicBoard<BoxSize>& board, int nLimit, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        BasicMRVSearch<BoxSize> search(board);
+        SearchStats stats;
+        int nSolutions = 0;
+        while (nSolutions < nLimit && search.next(pBudget, &stats))
+            nSolutions++;
+
+        if (pStats)
+            pStats->add(stats);
+        return search.stopped() ? 0 : nSolutions;
+    }
+
+    // fills the board with the first solution, false if there is none or the budget ran out
+    template <int BoxSize>
+    bool SearchBoardMRV(BasicBoard<BoxSize>& board, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        return CountBoardSolutions<BoxSize>(board, 1, pBudget, pStats) == 1;
+    }
+
+}
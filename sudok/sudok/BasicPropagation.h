@@ -0,0 +1,128 @@
+#pragma once
+#include "BasicBoard.h"
+#include "DigitMask.h"
+
+namespace KSudoku {
+
+    // the cells of each unit of a board, in the order of BasicBoard::unitCell, computed once
+    template <int BoxSize>
+    struct BasicUnits {
+        typedef BasicBoard<BoxSize> B;
+
+        BasicUnits()
+        {
+            for (int nUnit = 0; nUnit < B::UNITS; nUnit++)
+            {
+                for (int k = 0; k < B::SIZE; k++)
+                    cells[nUnit][k] = (unsigned short)B::unitCell(nUnit, k);
+            }
+        }
+
+        unsigned short  cells[B::UNITS][B::SIZE];
+    };
+
+    // naked singles: a null cell with a single candidate must take it
+    template <int BoxSize>
+    bool FillNakedSingles(BasicBoard<BoxSize>& board, bool& bChanged)
+    {
+        typedef BasicBoard<BoxSize> B;
+        for (int n = 0; n < B::CELLS; n++)
+        {
+            if (board.value(n) != 0)
+                continue;
+
+            typename B::Mask candidates = board.candidates(n);
+            if (candidates == 0)
+                return false;
+
+            if ((candidates & (candidates - 1)) == 0)
+            {
+                board.placeGiven(n, LowestDigit(candidates));
+                bChanged = true;
+            }
+        }
+
+        return true;
+    }
+
+    // hidden singles: a digit which fits only one cell of a row/column/sub-region must go there
+    template <int BoxSize>
+    bool FillHiddenSingles(BasicBoard<BoxSize>& board, const BasicUnits<BoxSize>& units, bool& bChanged)
+    {
+        typedef BasicBoard<BoxSize> B;
+        typedef typename B::Mask Mask;
+        for (int nUnit = 0; nUnit < B::UNITS; nUnit++)
+        {
+            const unsigned short* cells = units.cells[nUnit];
+            Mask placed = 0;
+            Mask once = 0;          // candidate of at least one cell
+            Mask more = 0;          // candidate of at least two cells
+            for (int k = 0; k < B::SIZE; k++)
+            {
+                int v = board.value(cells[k]);
+                if (v != 0)
+                {
+                    placed |= B::maskOf(v);
+                }
+                else
+                {
+                    Mask candidates = board.candidates(cells[k]);
+                    more |= once & candidates;
+                    once |= candidates;
+                }
+            }
+
+            // a digit which is neither placed nor fits any cell can't be placed anymore
+            if ((Mask)(placed | once) != B::ALL)
+                return false;
+
+            Mask singles = (Mask)(once & ~more);
+            while (singles)
+            {
+                int v = LowestDigit(singles);
+                singles &= singles - 1;
+
+                // two hidden singles in the same cell leave no cell for the second one
+                bool bFound = false;
+                for (int k = 0; k < B::SIZE && !bFound; k++)
+                {
+                    int n = cells[k];
+                    if (board.value(n) == 0 && (board.candidates(n) & B::maskOf(v)))
+                    {
+                        board.placeGiven(n, v);
+                        bFound = true;
+                    }
+                }
+                if (!bFound)
+                    return false;
+
+                bChanged = true;
+            }
+        }
+
+        return true;
+    }
+
+    // The singles of Propagation.cpp for a board of any size: every cell forced by naked or
+    // hidden singles is filled as a given cell, until there is none left. Returns false if the
+    // board is found to have a contradiction, which means no solution.
+    //
+    template <int BoxSize>
+    bool PropagateBoard(BasicBoard<BoxSize>& board)
+    {
+        static const BasicUnits<BoxSize> units;
+
+        bool bChanged = true;
+        while (bChanged)
+        {
+            bChanged = false;
+            if (!FillNakedSingles(board, bChanged))
+                return false;
+            if (!FillHiddenSingles(board, units, bChanged))
+                return false;
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,369 @@
+#include "stdafx.h"
+#include "Solver.h"
+#include "Batch.h"
+#include "ThreadPool.h"
+#include "Validator.h"
+#include "SearchStats.h"
+#include "PuzzleFile.h"
+#include "Archive.h"
+#include "SolutionCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace KSudoku {
+
+    const int BATCH_CHUNK_SIZE = 4096;      // puzzles read ahead at a time
+    const int BATCH_TASK_SIZE = 16;         // puzzles solved by one task
+    const int BATCH_CHUNKS_IN_FLIGHT = 3;   // chunks being solved while the oldest one is written
+
+    struct BatchRecord {
+        long long   nLine;
+        long long   nOffset;        // of the record in the input file
+        const char* pError;         // why the record isn't a valid puzzle
+        char        cells[81];      // the puzzle, 0 ~ 9 row by row, then its solution once solved
+        char        solution[82];   // the solution line, "\n" terminated
+        bool        bValid;
+        SolveStatus status;         // SOLVE_SOLVED once solved
+    };
+
+    struct BatchChunk {
+        BatchChunk() : records(BATCH_CHUNK_SIZE), nRecords(0) {}
+
+        std::vector<BatchRecord>    records;
+        int                         nRecords;
+        TaskGroup                   group;
+    };
+
+    // The records of a batch, read from a text file or from an archive (see Archive.h), the
+    // kind of file is told by its first bytes.
+    class BatchInput {
+    public:
+        bool open(const char* fileName)
+        {
+            if (!m_file.open(fileName))
+            {
+                fprintf(stderr, "can't open %s\n", fileName);
+                return false;
+            }
+
+            if (IsArchive(m_file.begin(), m_file.end()))
+            {
+                if (!m_archive.attach(m_file.begin(), m_file.end()))
+                {
+                    fprintf(stderr, "%s: %s\n", fileName, m_archive.error());
+                    return false;
+                }
+            }
+            else
+                m_pParser.reset(new PuzzleParser(m_file.begin(), m_file.end()));
+
+            return true;
+        }
+
+        bool isArchive() const { return !m_pParser; }
+        bool isCorrupt() const { return !m_pParser && m_archive.error(); }     // an archive which ended on a corrupt block
+
+        ParseResult next(char cells[81])
+        {
+            if (m_pParser)
+                return m_pParser->next(cells);
+
+            if (m_archive.next(cells))
+                return PARSE_PUZZLE;
+            if (m_archive.error())
+                fprintf(stderr, "record %lld: %s, the rest of the archive is skipped\n", m_archive.recordIndex() + 2, m_archive.error());
+            return PARSE_END;
+        }
+
+        // the line of the record in a text file, its number from 1 in an archive
+        long long   recordLine() const      { return m_pParser ? m_pParser->recordLine() : m_archive.recordIndex() + 1; }
+        long long   recordOffset() const    { return m_pParser ? m_pParser->recordOffset() : 0; }
+        const char* error() const           { return m_pParser ? m_pParser->error() : nullptr; }
+
+    private:
+        MappedFile                      m_file;
+        ArchiveReader                   m_archive;
+        std::unique_ptr<PuzzleParser>   m_pParser;
+    };
+
+    // where a record is reported, its line and offset in a text file or its number in an archive
+    void PrintRecordPosition(const BatchInput& input, long long nLine, long long nOffset)
+    {
+        if (input.isArchive())
+            fprintf(stderr, "record %lld: ", nLine);
+        else
+            fprintf(stderr, "line %lld, offset %lld: ", nLine, nOffset);
+    }
+
+    // parses the next chunk of puzzles straight into the records, returns how many were read
+    int ReadChunk(BatchInput& input, BatchChunk& chunk)
+    {
+        chunk.nRecords = 0;
+        while (chunk.nRecords < BATCH_CHUNK_SIZE)
+        {
+            BatchRecord& record = chunk.records[chunk.nRecords];
+            ParseResult result = input.next(record.cells);
+            if (result == PARSE_END)
+                break;
+
+            record.nLine = input.recordLine();
+            record.nOffset = input.recordOffset();
+            record.bValid = result == PARSE_PUZZLE;
+            record.pError = record.bValid ? nullptr : input.error();
+            record.status = SOLVE_NO_SOLUTION;
+            chunk.nRecords++;
+        }
+
+        return chunk.nRecords;
+    }
+
+    // solves the puzzles of one task, through the cache if there is one, adding to the stats of its worker if there are any
+    void SolveRecords(SolutionCache* pCache, const BatchOptions& options, SearchStats* pStats, BatchChunk& chunk,
+                      int nBegin, int nEnd)
+    {
+        SolveOptions solveOptions = DefaultSolveOptions();
+        solveOptions.limits.nMaxNodes = options.nMaxNodes;
+        char solution[81];
+        for (int n = nBegin; n < nEnd; n++)
+        {
+            BatchRecord& record = chunk.records[n];
+            if (!record.bValid)
+                continue;
+
+            // every puzzle has the whole time to itself
+            if (options.nTimeoutMs > 0)
+                solveOptions.limits.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.nTimeoutMs);
+            SolveStatus status = pCache ? SolveGridCached(*pCache, record.cells, solution, &solveOptions, pStats)
+                                        : SolveGrid(record.cells, solution, &solveOptions, pStats);
+            record.status = status;
+            if (status == SOLVE_INVALID_PUZZLE)
+            {
+                record.bValid = false;
+                record.pError = "a digit given twice in a row, column or sub-region";
+            }
+            else if (status == SOLVE_SOLVED)
+            {
+                memcpy(record.cells, solution, 81);
+                for (int i = 0; i < 81; i++)
+                    record.solution[i] = (char)('0' + solution[i]);
+                record.solution[81] = '\n';
+            }
+        }
+    }
+
+    // the solutions go to a text file with one line per puzzle, or to a solutions archive
+    // where a puzzle without one is an empty grid
+    struct BatchOutput {
+        FILE*           file;
+        ArchiveWriter*  pArchive;
+    };
+
+    // waits for the chunk and writes its results, returns the number of puzzles not solved
+    int WriteChunk(const BatchInput& input, BatchOutput& output, BatchChunk& chunk)
+    {
+        static const char EMPTY_GRID[81] = {};
+
+        chunk.group.wait();
+
+        int nFailed = 0;
+        for (int n = 0; n < chunk.nRecords; n++)
+        {
+            BatchRecord& record = chunk.records[n];
+            if (!record.bValid)
+            {
+                PrintRecordPosition(input, record.nLine, record.nOffset);
+                fprintf(stderr, "invalid puzzle, %s\n", record.pError);
+                nFailed++;
+            }
+            else if (record.status != SOLVE_SOLVED)
+            {
+                nFailed++;
+            }
+
+            if (output.pArchive)
+                output.pArchive->write(record.status == SOLVE_SOLVED ? record.cells : EMPTY_GRID);
+            else if (!record.bValid)
+                fputs("invalid\n", output.file);
+            else if (record.status != SOLVE_SOLVED)
+                fprintf(output.file, "%s\n", SolveStatusName(record.status));
+            else
+                fwrite(record.solution, 1, sizeof(record.solution), output.file);
+        }
+
+        return nFailed;
+    }
+
+    // The file is mapped into memory and read in chunks of puzzles. Each chunk is cut into small tasks for the worker
+    // pool, every worker solving with SolveGrid into its own stats, and the chunks are written back in input order
+    // once solved. Only a few chunks are alive at a time, so a file of any size is solved in
+    // constant memory, and as the next chunks are already being solved a hard puzzle only
+    // delays the writing, not the workers.
+    //
+    int SolveBatch(const char* inputFileName, const char* outputFileName, const BatchOptions& options, SearchStats* pStats)
+    {
+        BatchInput input;
+        if (!input.open(inputFileName))
+            return -1;
+
+        BatchOutput output = { stdout, nullptr };
+        ArchiveWriter archive;
+        if (IsArchiveFileName(outputFileName))
+        {
+            if (!archive.open(outputFileName, ARCHIVE_SOLUTIONS, options.bCompress))
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+            output.file = nullptr;
+            output.pArchive = &archive;
+        }
+        else if (outputFileName)
+        {
+            output.file = fopen(outputFileName, "w");
+            if (!output.file)
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+        }
+        if (output.file)
+            setvbuf(output.file, NULL, _IOFBF, 1 << 16);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        WorkStealingPool pool(options.nThreads);
+        std::unique_ptr<SolutionCache> cache;
+        if (options.nCacheEntries > 0)
+            cache.reset(new SolutionCache(options.nCacheEntries, pool.numWorkers() * 4));
+        SolutionCache* pCache = cache.get();
+        std::vector<SearchStats> workerStats(pool.numWorkers());
+        std::unique_ptr<BatchChunk> chunks[BATCH_CHUNKS_IN_FLIGHT];
+        for (int i = 0; i < BATCH_CHUNKS_IN_FLIGHT; i++)
+            chunks[i].reset(new BatchChunk());
+
+        long long nPuzzles = 0;
+        long long nSubmitted = 0;   // chunks handed to the pool
+        long long nWritten = 0;     // chunks written back
+        int nFailed = 0;
+        for (;;)
+        {
+            if (nSubmitted - nWritten == BATCH_CHUNKS_IN_FLIGHT)
+            {
+                nFailed += WriteChunk(input, output, *chunks[nWritten % BATCH_CHUNKS_IN_FLIGHT]);
+                nWritten++;
+            }
+
+            BatchChunk& chunk = *chunks[nSubmitted % BATCH_CHUNKS_IN_FLIGHT];
+            int nRead;
+            {
+                PhaseTimer timer(pStats, PHASE_PARSE);
+                nRead = ReadChunk(input, chunk);
+            }
+            if (nRead == 0)
+                break;
+
+            nPuzzles += chunk.nRecords;
+            for (int n = 0; n < chunk.nRecords; n += BATCH_TASK_SIZE)
+            {
+                int nEnd = n + BATCH_TASK_SIZE < chunk.nRecords ? n + BATCH_TASK_SIZE : chunk.nRecords;
+                BatchChunk* pChunk = &chunk;
+                bool bStats = pStats != nullptr;
+                pool.submit(chunk.group, [&workerStats, &options, pCache, bStats, pChunk, n, nEnd](int nWorker) {
+                    SolveRecords(pCache, options, bStats ? &workerStats[nWorker] : nullptr, *pChunk, n, nEnd);
+                });
+            }
+            nSubmitted++;
+        }
+
+        while (nWritten < nSubmitted)
+        {
+            nFailed += WriteChunk(input, output, *chunks[nWritten % BATCH_CHUNKS_IN_FLIGHT]);
+            nWritten++;
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (pStats)
+        {
+            for (size_t k = 0; k < workerStats.size(); k++)
+                pStats->add(workerStats[k]);
+        }
+
+        if (output.pArchive && !archive.close())
+            fprintf(stderr, "can't write %s\n", outputFileName);
+        else if (output.file && output.file != stdout)
+            fclose(output.file);
+        else if (output.file)
+            fflush(output.file);
+
+        fprintf(stderr, "%lld puzzles, %lld solved in %.3f s with %d threads, %.0f puzzles/second\n",
+            nPuzzles, nPuzzles - nFailed, seconds, pool.numWorkers(), seconds > 0 ? nPuzzles / seconds : 0.0);
+        if (cache)
+            fprintf(stderr, "cache: %llu hits, %llu misses\n", cache->hits(), cache->misses());
+
+        return input.isCorrupt() ? -1 : nFailed;
+    }
+
+    // The grids are parsed into a block of 81 byte grids and the whole block is validated by one
+    // call, so the validator can keep its vector registers busy over thousands of grids.
+    //
+    int ValidateBatch(const char* inputFileName)
+    {
+        BatchInput input;
+        if (!input.open(inputFileName))
+            return -1;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        std::vector<unsigned char> grids(BATCH_CHUNK_SIZE * 81);
+        std::vector<unsigned char> results(BATCH_CHUNK_SIZE);
+        std::vector<long long> lines(BATCH_CHUNK_SIZE);
+        std::vector<long long> offsets(BATCH_CHUNK_SIZE);
+        long long nGrids = 0;
+        int nInvalid = 0;
+        bool bEnd = false;
+        while (!bEnd)
+        {
+            int nInChunk = 0;
+            while (nInChunk < BATCH_CHUNK_SIZE)
+            {
+                unsigned char* grid = &grids[nInChunk * 81];
+                ParseResult result = input.next((char*)grid);
+                if (result == PARSE_END)
+                {
+                    bEnd = true;
+                    break;
+                }
+
+                // a record which doesn't even parse is left as zeros, which never validate
+                if (result == PARSE_MALFORMED)
+                    memset(grid, 0, 81);
+                lines[nInChunk] = input.recordLine();
+                offsets[nInChunk] = input.recordOffset();
+                nInChunk++;
+            }
+
+            ValidateGrids(&grids[0], nInChunk, &results[0]);
+            for (int k = 0; k < nInChunk; k++)
+            {
+                if (!results[k])
+                {
+                    PrintRecordPosition(input, lines[k], offsets[k]);
+                    fprintf(stderr, "invalid solution\n");
+                    nInvalid++;
+                }
+            }
+            nGrids += nInChunk;
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        fprintf(stderr, "%lld grids, %lld valid in %.3f s (%s), %.0f grids/second\n",
+            nGrids, nGrids - nInvalid, seconds, ValidatorInstructionSet(), seconds > 0 ? nGrids / seconds : 0.0);
+
+        return input.isCorrupt() ? -1 : nInvalid;
+    }
+
+}
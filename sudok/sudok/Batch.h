@@ -0,0 +1,30 @@
+#pragma once
+#include <stddef.h>
+
+namespace KSudoku {
+    struct SearchStats;
+
+    struct BatchOptions {
+        int                 nThreads;
+        bool                bCompress;      // compress the blocks of an archive output file
+        size_t              nCacheEntries;  // solutions kept in a SolutionCache, 0 for no cache
+        long long           nTimeoutMs;     // the time the search of one puzzle may take, 0 for no limit
+        unsigned long long  nMaxNodes;      // and its nodes, 0 for no limit
+    };
+
+    // Solves every puzzle of a file with one puzzle per line, 81 characters with "0" or "." for
+    // the null cells, or nine lines of nine cells per puzzle (see PuzzleParser), or of a puzzles
+    // archive (see Archive.h), on nThreads worker threads, and writes one line per puzzle in
+    // input order to the output file (stdout if NULL). An output file named *.ksa is written as
+    // a solutions archive instead, compressed if bCompress. With a cache the puzzles which are
+    // symmetries of one already solved are only looked up (see SolutionCache.h). A puzzle whose
+    // search runs out of time or nodes gets a "timed out" or "node limit reached" line. The
+    // stats of all the puzzles are added to pStats unless it is NULL.
+    // Returns the number of puzzles which could not be solved, or -1 if a file can't be opened
+    // or the archive is corrupt.
+    int SolveBatch(const char* inputFileName, const char* outputFileName, const BatchOptions& options, SearchStats* pStats);
+
+    // Validates every solution of a file in the same formats, or of an archive, reporting the invalid ones.
+    // Returns the number of invalid grids, or -1 if the file can't be opened or the archive is corrupt.
+    int ValidateBatch(const char* inputFileName);
+}
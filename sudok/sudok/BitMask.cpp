@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "BitMask.h"
+#include "SearchBudget.h"
+#include "SearchStats.h"
+
+namespace KSudoku {
+
+    bool ProcessCellByMask(Board& board, int n, SearchBudget* pBudget, SearchStats& stats);
+
+    // Algorithm:
+    //
+    // The same walk as the backtracking solver, but the board keeps a mask of the digits used
+    // in every row, column and sub-region. The legal numbers of a null cell are then simply
+    // the digits missing from all three masks, so instead of filling "1" ~ "9" and verifying
+    // the row/column/sub-region each time, we only try the candidates, lowest bit first.
+    //
+    bool SearchBitMask(Board& board, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        PhaseTimer timer(pStats, PHASE_SEARCH);
+        SearchStats stats;
+        bool b = ProcessCellByMask(board, 0, pBudget, stats);
+        if (b)
+        {
+            b = VerifySolution(board);
+        }
+
+        if (pStats)
+            pStats->add(stats);
+        return b;
+    }
+
+    bool ProcessCellByMask(Board& board, int n, SearchBudget* pBudget, SearchStats& stats) {
+        if (board.isGiven(n))
+        {
+            if (n + 1 < Board::CELLS)
+                return ProcessCellByMask(board, n + 1, pBudget, stats);
+            else
+                return true;
+        }
+
+        DigitMask candidates = board.candidates(n);
+        KSUDOKU_COUNT(stats.nBranches++);
+        KSUDOKU_COUNT(stats.nCandidates += CountDigits(candidates));
+        while (candidates)
+        {
+            if (pBudget && pBudget->spend())
+                return false;
+
+            board.place(n, LowestDigit(candidates));
+            candidates &= candidates - 1;       // drop the lowest bit
+            KSUDOKU_COUNT(stats.nNodes++);
+
+            if (n + 1 == Board::CELLS || ProcessCellByMask(board, n + 1, pBudget, stats))
+                return true;
+
+            board.remove(n);
+            KSUDOKU_COUNT(stats.nBacktracks++);
+        }
+
+        return false;       // we exhaust all the candidates in this cell
+    }
+
+}
@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "BlockCompressor.h"
+#include <string.h>
+#include <vector>
+
+namespace KSudoku {
+
+    const int LZ_MIN_MATCH = 4;
+    const int LZ_HASH_BITS = 12;
+    const size_t LZ_MAX_OFFSET = 65535;
+
+    inline unsigned int ReadU32(const unsigned char* p)
+    {
+        unsigned int v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    inline unsigned int HashU32(unsigned int v)
+    {
+        return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+    }
+
+    // writes the rest of a length which didn't fit in its 4 bits
+    inline unsigned char* PutLength(unsigned char* out, size_t n)
+    {
+        while (n >= 255)
+        {
+            *out++ = 255;
+            n -= 255;
+        }
+        *out++ = (unsigned char)n;
+        return out;
+    }
+
+    // Algorithm: greedy matching with a hash table of the last position of every 4 byte
+    // sequence. The sequence at the cursor is looked up, if it is found within the 16 bit window
+    // the match is extended as far as it goes and written with the literals before it, otherwise
+    // the cursor moves on by one byte. The literals after the last match end the block.
+    //
+    size_t CompressBlock(const unsigned char* src, size_t n, unsigned char* dst, size_t capacity)
+    {
+        if (capacity < CompressBound(n))
+            return 0;
+
+        std::vector<long long> table(1 << LZ_HASH_BITS, -1);
+        unsigned char* out = dst;
+        size_t nLiteral = 0;        // the start of the pending literals
+        size_t i = 0;
+
+        while (n >= LZ_MIN_MATCH && i <= n - LZ_MIN_MATCH)
+        {
+            unsigned int v = ReadU32(src + i);
+            unsigned int h = HashU32(v);
+            long long candidate = table[h];
+            table[h] = (long long)i;
+
+            if (candidate < 0 || i - (size_t)candidate > LZ_MAX_OFFSET || ReadU32(src + candidate) != v)
+            {
+                i++;
+                continue;
+            }
+
+            size_t nMatch = LZ_MIN_MATCH;
+            while (i + nMatch < n && src[candidate + nMatch] == src[i + nMatch])
+                nMatch++;
+
+            size_t nLiterals = i - nLiteral;
+            size_t nExtra = nMatch - LZ_MIN_MATCH;
+            unsigned char* token = out++;
+            *token = (unsigned char)(((nLiterals < 15 ? nLiterals : 15) << 4) | (nExtra < 15 ? nExtra : 15));
+            if (nLiterals >= 15)
+                out = PutLength(out, nLiterals - 15);
+            memcpy(out, src + nLiteral, nLiterals);
+            out += nLiterals;
+
+            size_t offset = i - (size_t)candidate;
+            *out++ = (unsigned char)(offset & 0xFF);
+            *out++ = (unsigned char)(offset >> 8);
+            if (nExtra >= 15)
+                out = PutLength(out, nExtra - 15);
+
+            i += nMatch;
+            nLiteral = i;
+        }
+
+        // the last sequence is only literals
+        size_t nLiterals = n - nLiteral;
+        *out++ = (unsigned char)((nLiterals < 15 ? nLiterals : 15) << 4);
+        if (nLiterals >= 15)
+            out = PutLength(out, nLiterals - 15);
+        memcpy(out, src + nLiteral, nLiterals);
+        out += nLiterals;
+
+        return (size_t)(out - dst);
+    }
+
+    // reads the rest of a length, false if the block ends first
+    inline bool GetLength(const unsigned char*& in, const unsigned char* end, size_t& n)
+    {
+        unsigned char b;
+        do
+        {
+            if (in == end)
+                return false;
+            b = *in++;
+            n += b;
+        } while (b == 255);
+        return true;
+    }
+
+    long long DecompressBlock(const unsigned char* src, size_t n, unsigned char* dst, size_t capacity)
+    {
+        const unsigned char* in = src;
+        const unsigned char* end = src + n;
+        size_t nOut = 0;
+
+        while (in != end)
+        {
+            unsigned char token = *in++;
+
+            size_t nLiterals = token >> 4;
+            if (nLiterals == 15 && !GetLength(in, end, nLiterals))
+                return -1;
+            if (nLiterals > (size_t)(end - in) || nLiterals > capacity - nOut)
+                return -1;
+            memcpy(dst + nOut, in, nLiterals);
+            in += nLiterals;
+            nOut += nLiterals;
+
+            if (in == end)
+                break;      // the last sequence
+
+            if (end - in < 2)
+                return -1;
+            size_t offset = in[0] | (in[1] << 8);
+            in += 2;
+            size_t nMatch = token & 0x0F;
+            if (nMatch == 15 && !GetLength(in, end, nMatch))
+                return -1;
+            nMatch += LZ_MIN_MATCH;
+            if (offset == 0 || offset > nOut || nMatch > capacity - nOut)
+                return -1;
+
+            // byte by byte, a match may overlap the bytes it writes
+            const unsigned char* from = dst + nOut - offset;
+            for (size_t k = 0; k < nMatch; k++)
+                dst[nOut + k] = from[k];
+            nOut += nMatch;
+        }
+
+        return (long long)nOut;
+    }
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stddef.h>
+
+namespace KSudoku {
+
+    // A small LZ77 compressor for the blocks of an archive, in the spirit of LZ4: a block is a
+    // run of sequences, each a token byte (literal length, match length - 4), the literals, and
+    // a 16 bit offset back to the match. Lengths of 15 and more go on in extra bytes of 255.
+    // It is fast rather than tight, a block which doesn't shrink is better stored as it is.
+
+    // the most a block of n bytes can take compressed
+    inline size_t CompressBound(size_t n) { return n + n / 255 + 16; }
+
+    // compresses n bytes into dst, returns the compressed size or 0 if it doesn't fit in capacity
+    size_t CompressBlock(const unsigned char* src, size_t n, unsigned char* dst, size_t capacity);
+
+    // returns the decompressed size, or -1 if the block is corrupt or doesn't fit in capacity
+    long long DecompressBlock(const unsigned char* src, size_t n, unsigned char* dst, size_t capacity);
+}
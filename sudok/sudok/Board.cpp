@@ -0,0 +1,75 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "Validator.h"
+#include <stdio.h>
+
+namespace KSudoku {
+
+    const BoardUnits BOARD_UNITS;
+
+    BoardUnits::BoardUnits()
+    {
+        for (int n = 0; n < 81; n++)
+        {
+            int nPeers = 0;
+            for (int p = 0; p < 81; p++)
+            {
+                if (p != n && (Board::rowOf(p) == Board::rowOf(n) || Board::columnOf(p) == Board::columnOf(n)
+                               || Board::boxOf(p) == Board::boxOf(n)))
+                    peers[n][nPeers++] = (unsigned char)p;
+            }
+        }
+    }
+
+    bool LoadBoard(Board& board, const char cells[81])
+    {
+        board.clear();
+        for (int n = 0; n < 81; n++)
+        {
+            int v = cells[n];
+            if (v < 0 || v > 9)
+                return false;
+            if (v == 0)
+                continue;
+
+            // the same given twice in a row/column/sub-region can never be solved
+            if (!(board.candidates(n) & Board::maskOf(v)))
+                return false;
+            board.placeGiven(n, v);
+        }
+
+        return true;
+    }
+
+    void StoreBoard(const Board& board, char cells[81])
+    {
+        for (int n = 0; n < 81; n++)
+            cells[n] = (char)board.value(n);
+    }
+
+    bool VerifySolution(const Board& board)
+    {
+        return ValidateGrid(board.values());
+    }
+
+    void PrintBoard(const Board& board)
+    {
+        for (int i = 0; i < 9; i++)
+        {
+            for (int j = 0; j < 9; j++)
+            {
+                printf("%d ", board.value(i * 9 + j));
+                if ((j + 1) % 3 == 0)
+                {
+                    printf(" ");
+                }
+            }
+            if ((i + 1) % 3 == 0)
+            {
+                printf("\n");
+            }
+            printf("\n");
+        }
+    }
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "BasicBoard.h"
+
+namespace KSudoku {
+
+    // The 9x9 board every solver runs on: 81 values, the given cells in 11 bytes and the 27
+    // masks, 146 bytes in all, copied with a memcpy.
+    typedef BasicBoard<3> Board;
+
+    // the peers of each cell of the 9x9 board, computed once (the cells of the units are in
+    // BasicUnits, BasicPropagation.h)
+    struct BoardUnits {
+        BoardUnits();
+
+        unsigned char   peers[81][20];      // the other cells of the row, column and sub-region of a cell
+    };
+
+    extern const BoardUnits BOARD_UNITS;
+
+    // replaces the board with the cells 0 ~ 9 row by row, the non null ones given, false if a
+    // cell is out of range or a digit is given twice in a row, column or sub-region
+    bool LoadBoard(Board& board, const char cells[81]);
+    void StoreBoard(const Board& board, char cells[81]);        // the values row by row, 0 for null cells
+
+    bool VerifySolution(const Board& board);        // every cell filled and every unit holding each digit once
+    void PrintBoard(const Board& board);
+
+}
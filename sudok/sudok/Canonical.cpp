@@ -0,0 +1,303 @@
+#include "stdafx.h"
+#include "Canonical.h"
+#include <string.h>
+#include <vector>
+
+namespace KSudoku {
+
+    const int CANONICAL_MAX_STATES = 4096;          // candidate transforms kept per row
+
+    const unsigned char PERMUTATIONS_OF_3[6][3] = {
+        { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+    };
+
+    // the 3 bit pattern of a stack with n givens pushed to its left, the largest it can read
+    const int LEFT_ALIGNED[4] = { 0, 4, 6, 7 };
+
+    // how a null cell reads while the rows are compared, after every digit
+    const char NULL_CELL = 10;
+
+    // a transform being built, the rows of the canonical grid above the current one are chosen
+    struct CanonicalState {
+        unsigned char   rows[9];
+        unsigned char   columns[9];
+        unsigned char   digits[10];
+        unsigned char   nextDigit;
+        unsigned char   bandsUsed;      // a bit per band of the grid
+        bool            bTranspose;
+    };
+
+    inline int CellOf(const char grid[81], bool bTranspose, int i, int j)
+    {
+        return bTranspose ? grid[j * 9 + i] : grid[i * 9 + j];
+    }
+
+    // the givens of row i of the grid, 3 bits per stack with the first column as the high bit
+    inline int StackPattern(const char grid[81], bool bTranspose, int i, int s, const unsigned char perm[3])
+    {
+        int pattern = 0;
+        for (int m = 0; m < 3; m++)
+            pattern = (pattern << 1) | (CellOf(grid, bTranspose, i, s * 3 + perm[m]) != 0);
+        return pattern;
+    }
+
+    // Adds the transforms which make row i of the grid the smallest first row it can be, and
+    // returns that first row as a 9 bit pattern of givens, the larger the better. Whatever the
+    // digits, the first row of a canonical grid reads 1, 2, 3 ... in its given cells, so only
+    // where they are matters: the stacks with the most givens first, and the givens of each to
+    // its left.
+    //
+    int AddFirstRows(const char grid[81], bool bTranspose, int i, int bestPattern, std::vector<CanonicalState>& states)
+    {
+        static const unsigned char IDENTITY[3] = { 0, 1, 2 };
+
+        int counts[3];
+        for (int s = 0; s < 3; s++)
+        {
+            int stack = StackPattern(grid, bTranspose, i, s, IDENTITY);
+            counts[s] = (stack & 1) + ((stack >> 1) & 1) + (stack >> 2);
+        }
+
+        int sorted[3] = { counts[0], counts[1], counts[2] };
+        for (int a = 0; a < 2; a++)
+            for (int b = a + 1; b < 3; b++)
+                if (sorted[b] > sorted[a]) { int t = sorted[a]; sorted[a] = sorted[b]; sorted[b] = t; }
+        int pattern = (LEFT_ALIGNED[sorted[0]] << 6) | (LEFT_ALIGNED[sorted[1]] << 3) | LEFT_ALIGNED[sorted[2]];
+
+        if (pattern < bestPattern)
+            return pattern;
+        if (pattern > bestPattern)
+            states.clear();
+
+        for (int o = 0; o < 6; o++)
+        {
+            const unsigned char* order = PERMUTATIONS_OF_3[o];
+            if (counts[order[0]] < counts[order[1]] || counts[order[1]] < counts[order[2]])
+                continue;
+
+            // the orders of the columns of each stack which push its givens to the left
+            int valid[3][6];
+            int nValid[3];
+            for (int k = 0; k < 3; k++)
+            {
+                nValid[k] = 0;
+                for (int p = 0; p < 6; p++)
+                {
+                    if (StackPattern(grid, bTranspose, i, order[k], PERMUTATIONS_OF_3[p]) == LEFT_ALIGNED[counts[order[k]]])
+                        valid[k][nValid[k]++] = p;
+                }
+            }
+
+            for (int a = 0; a < nValid[0]; a++)
+            {
+                for (int b = 0; b < nValid[1]; b++)
+                {
+                    for (int c = 0; c < nValid[2] && (int)states.size() < CANONICAL_MAX_STATES; c++)
+                    {
+                        CanonicalState state;
+                        state.bTranspose = bTranspose;
+                        state.rows[0] = (unsigned char)i;
+                        state.bandsUsed = (unsigned char)(1 << (i / 3));
+                        const int chosen[3] = { valid[0][a], valid[1][b], valid[2][c] };
+                        for (int k = 0; k < 3; k++)
+                        {
+                            for (int m = 0; m < 3; m++)
+                                state.columns[k * 3 + m] = (unsigned char)(order[k] * 3 + PERMUTATIONS_OF_3[chosen[k]][m]);
+                        }
+
+                        memset(state.digits, 0, sizeof(state.digits));
+                        state.nextDigit = 1;
+                        for (int j = 0; j < 9; j++)
+                        {
+                            int v = CellOf(grid, bTranspose, i, state.columns[j]);
+                            if (v)
+                                state.digits[v] = state.nextDigit++;
+                        }
+                        states.push_back(state);
+                    }
+                }
+            }
+        }
+
+        return pattern;
+    }
+
+    // Algorithm:
+    //
+    // The grids are compared row by row with their digits labeled 1 ~ 9 in order of first
+    // appearance, and a null cell reading after every digit. Putting the givens first rather
+    // than the null cells starts the canonical grid on its fullest row, whose givens leave
+    // far fewer orders of the columns open than the empty stacks of a sparse row would.
+    //
+    // 1. Find every transform which gives the smallest first row (see AddFirstRows). That fixes
+    //    the transposition, the order of the columns and the first digits.
+    // 2. For the next row of the canonical grid, try every row each transform may take there:
+    //    the other rows of the band for the 2nd and 3rd row of a band, any row of a band not
+    //    used yet for the 1st. Read it through the columns, labeling its new digits in order.
+    // 3. Keep only the transforms whose row reads the smallest, and go on with the next row.
+    //
+    // After the 9th row every transform left gives the canonical grid. Usually the givens of
+    // the first rows leave a handful of transforms, so the whole search is a few thousand cells.
+    //
+    void CanonicalizeGrid(const char grid[81], char canonical[81], GridTransform& transform)
+    {
+        // a few hundred transforms at most for most grids, the vectors grow if it takes more
+        std::vector<CanonicalState> states;
+        std::vector<CanonicalState> next;
+        states.reserve(256);
+        next.reserve(256);
+
+        // the grid and its transpose, so reading a row of either is the same
+        char transposed[81];
+        for (int n = 0; n < 81; n++)
+            transposed[n] = grid[n % 9 * 9 + n / 9];
+        const char* grids[2] = { grid, transposed };
+
+        int bestPattern = -1;
+        for (int t = 0; t < 2; t++)
+        {
+            for (int i = 0; i < 9; i++)
+            {
+                int pattern = AddFirstRows(grid, t == 1, i, bestPattern, states);
+                if (pattern > bestPattern)
+                    bestPattern = pattern;
+            }
+        }
+
+        // the first row of any of them
+        {
+            const CanonicalState& state = states[0];
+            for (int j = 0; j < 9; j++)
+                canonical[j] = (char)state.digits[CellOf(grid, state.bTranspose, state.rows[0], state.columns[j])];
+        }
+
+        for (int r = 1; r < 9; r++)
+        {
+            char best[9];
+            bool bHasBest = false;
+            next.clear();
+
+            for (size_t k = 0; k < states.size(); k++)
+            {
+                const CanonicalState& state = states[k];
+                const char* g = grids[state.bTranspose];
+
+                // the rows it may take next
+                int candidates[9];
+                int nCandidates = 0;
+                if (r % 3 == 0)
+                {
+                    for (int b = 0; b < 3; b++)
+                    {
+                        if (!(state.bandsUsed & (1 << b)))
+                            for (int m = 0; m < 3; m++)
+                                candidates[nCandidates++] = b * 3 + m;
+                    }
+                }
+                else
+                {
+                    int band = state.rows[r - 1] / 3;
+                    for (int m = 0; m < 3; m++)
+                    {
+                        int i = band * 3 + m;
+                        bool bUsed = false;
+                        for (int q = r - r % 3; q < r; q++)
+                            bUsed = bUsed || state.rows[q] == i;
+                        if (!bUsed)
+                            candidates[nCandidates++] = i;
+                    }
+                }
+
+                for (int c = 0; c < nCandidates; c++)
+                {
+                    int i = candidates[c];
+                    const char* source = g + i * 9;
+                    unsigned char digits[10];
+                    memcpy(digits, state.digits, sizeof(digits));
+                    int nextDigit = state.nextDigit;
+
+                    char row[9];
+                    int cmp = bHasBest ? 0 : -1;        // so far the row reads the same as the best
+                    for (int j = 0; j < 9; j++)
+                    {
+                        int v = source[state.columns[j]];
+                        if (v && !digits[v])
+                            digits[v] = (unsigned char)nextDigit++;
+                        row[j] = v ? (char)digits[v] : NULL_CELL;
+                        if (cmp == 0 && row[j] != best[j])
+                        {
+                            cmp = row[j] < best[j] ? -1 : 1;
+                            if (cmp > 0)
+                                break;
+                        }
+                    }
+                    if (cmp > 0)
+                        continue;
+
+                    if (cmp < 0)
+                    {
+                        memcpy(best, row, sizeof(best));
+                        bHasBest = true;
+                        next.clear();
+                    }
+                    if ((int)next.size() < CANONICAL_MAX_STATES)
+                    {
+                        CanonicalState child = state;
+                        memcpy(child.digits, digits, sizeof(digits));
+                        child.nextDigit = (unsigned char)nextDigit;
+                        child.rows[r] = (unsigned char)i;
+                        if (r % 3 == 0)
+                            child.bandsUsed |= (unsigned char)(1 << (i / 3));
+                        next.push_back(child);
+                    }
+                }
+            }
+
+            for (int j = 0; j < 9; j++)
+                canonical[r * 9 + j] = best[j] == NULL_CELL ? 0 : best[j];
+            states.swap(next);
+        }
+
+        const CanonicalState& state = states[0];
+        transform.bTranspose = state.bTranspose;
+        memcpy(transform.rows, state.rows, sizeof(transform.rows));
+        memcpy(transform.columns, state.columns, sizeof(transform.columns));
+        memcpy(transform.digits, state.digits, sizeof(transform.digits));
+
+        // the digits which aren't given take the labels left, in order
+        int nextDigit = state.nextDigit;
+        for (int v = 1; v <= 9; v++)
+        {
+            if (!transform.digits[v])
+                transform.digits[v] = (unsigned char)nextDigit++;
+        }
+    }
+
+    void TransformGrid(const GridTransform& transform, const char grid[81], char out[81])
+    {
+        for (int i = 0; i < 9; i++)
+        {
+            for (int j = 0; j < 9; j++)
+                out[i * 9 + j] = (char)transform.digits[CellOf(grid, transform.bTranspose, transform.rows[i], transform.columns[j])];
+        }
+    }
+
+    void UntransformGrid(const GridTransform& transform, const char transformed[81], char out[81])
+    {
+        unsigned char inverse[10];
+        for (int v = 0; v <= 9; v++)
+            inverse[transform.digits[v]] = (unsigned char)v;
+
+        for (int i = 0; i < 9; i++)
+        {
+            for (int j = 0; j < 9; j++)
+            {
+                int r = transform.rows[i];
+                int c = transform.columns[j];
+                int n = transform.bTranspose ? c * 9 + r : r * 9 + c;
+                out[n] = (char)inverse[(unsigned char)transformed[i * 9 + j]];
+            }
+        }
+    }
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace KSudoku {
+
+    // One of the symmetries of sudoku which keep a grid valid: an optional transposition, then
+    // a permutation of the rows which keeps the bands together, the same for the columns, and
+    // a relabeling of the digits. Cell (i, j) of the transformed grid is
+    //
+    //   digits[g[rows[i]][columns[j]]]     where g is the grid, transposed if bTranspose
+    //
+    struct GridTransform {
+        bool            bTranspose;
+        unsigned char   rows[9];
+        unsigned char   columns[9];
+        unsigned char   digits[10];     // digits[0] is always 0, a null cell stays null
+    };
+
+    // Finds the canonical form of a grid, the smallest of all its symmetric grids read row by
+    // row, with the digits labeled in order of first appearance and the null cells reading
+    // after every digit, and the transform which gives it. The cells must be 0 ~ 9.
+    //
+    // Two grids with the same canonical form are always symmetries of each other, since the
+    // form is a symmetry of each. The converse holds except for a grid with very many
+    // symmetries of its own, a nearly empty one: only the first few thousand candidate transforms
+    // are kept on the way (CANONICAL_MAX_STATES), so its form is still one of its symmetric grids but may
+    // miss being the smallest, and a symmetry of it may get another form. For the solution
+    // cache this can only cost a miss, never a wrong hit.
+    void CanonicalizeGrid(const char grid[81], char canonical[81], GridTransform& transform);
+
+    // the grid through the transform, and back
+    void TransformGrid(const GridTransform& transform, const char grid[81], char out[81]);
+    void UntransformGrid(const GridTransform& transform, const char transformed[81], char out[81]);
+}
@@ -0,0 +1,23 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "BasicMRV.h"
+#include "Count.h"
+#include "SearchStats.h"
+
+namespace KSudoku {
+
+    // The search runs on a copy of the board on the stack and stops as soon as nLimit solutions are
+    // counted, so checking uniqueness costs at most two solutions worth of search and never
+    // allocates.
+    //
+    int CountSolutions(const Board& board, int nLimit, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        if (nLimit < 1)
+            return 0;
+
+        PhaseTimer timer(pStats, PHASE_SEARCH);
+        Board copy = board;
+        return CountBoardSolutions<3>(copy, nLimit, pBudget, pStats);
+    }
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace KSudoku {
+    template <int BoxSize> class BasicBoard;
+    typedef BasicBoard<3> Board;
+    struct SearchStats;
+    class SearchBudget;
+
+    // Counts the solutions of the board up to nLimit, without printing and without touching
+    // the board. A limit of 2 is enough to tell whether the solution is unique. Returns 0 if the
+    // budget runs out. pBudget and pStats may be NULL.
+    int CountSolutions(const Board& board, int nLimit, SearchBudget* pBudget, SearchStats* pStats);
+}
@@ -0,0 +1,255 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "DLX.h"
+#include "SearchBudget.h"
+#include "SearchStats.h"
+
+namespace KSudoku {
+
+    // Sudoku as an exact cover problem:
+    //
+    // every choice "cell (i, j) takes digit v" is a matrix row, 729 rows in total, and it covers
+    // exactly 4 of the 324 columns, the constraints which must each be met once and only once:
+    //
+    //   column   0 ~  80: cell (i, j) has a digit
+    //   column  81 ~ 161: row i has digit v
+    //   column 162 ~ 242: column j has digit v
+    //   column 243 ~ 323: sub-region b has digit v
+    //
+    const int DLX_COLUMNS = 324;
+    const int DLX_ROWS = 729;
+    const int DLX_ROOT = 0;                                         // node 0 is the root header
+    const int DLX_NODES = 1 + DLX_COLUMNS + DLX_ROWS * 4;          // column headers are nodes 1 ~ 324
+
+    // All the links live in fixed arrays indexed by node, so building the matrix never allocates
+    // and the whole structure is a single contiguous block of about 40KB.
+    //
+    class DancingLinks {
+    public:
+        void build();
+        bool selectRow(int row);        // takes a given, false if it collides with another given
+        bool search(int depth, SearchBudget* pBudget);
+
+        int  solutionDepth() const      { return m_nSolutionDepth; }
+        int  solutionRow(int k) const   { return m_rowOf[m_solution[k]]; }
+        const SearchStats& stats() const { return m_stats; }
+
+    private:
+        void cover(int c);
+        void uncover(int c);
+        void addRow(int row, const int columns[4]);
+
+    private:
+        short   m_left[DLX_NODES];
+        short   m_right[DLX_NODES];
+        short   m_up[DLX_NODES];
+        short   m_down[DLX_NODES];
+        short   m_columnOf[DLX_NODES];     // the column header of a node
+        short   m_rowOf[DLX_NODES];        // the matrix row of a node
+        short   m_size[DLX_COLUMNS + 1];   // the number of nodes left in a column
+        short   m_solution[81];            // one node of each row taken
+        int     m_nNodes;
+        int     m_nSolutionDepth;
+        SearchStats m_stats;            // a node is a row tried by search
+    };
+
+    void DancingLinks::build()
+    {
+        // the root and the column headers form the header ring
+        for (int c = 0; c <= DLX_COLUMNS; c++)
+        {
+            m_left[c] = (short)(c == 0 ? DLX_COLUMNS : c - 1);
+            m_right[c] = (short)(c == DLX_COLUMNS ? 0 : c + 1);
+            m_up[c] = (short)c;
+            m_down[c] = (short)c;
+            m_columnOf[c] = (short)c;
+            m_rowOf[c] = -1;
+            m_size[c] = 0;
+        }
+        m_nNodes = DLX_COLUMNS + 1;
+        m_nSolutionDepth = 0;
+        m_stats = SearchStats();
+
+        for (int row = 0; row < DLX_ROWS; row++)
+        {
+            int n = row / 9;
+            int i = n / 9;
+            int j = n % 9;
+            int v = row % 9;
+
+            int columns[4];
+            columns[0] = 1 + n;
+            columns[1] = 1 + 81 + i * 9 + v;
+            columns[2] = 1 + 162 + j * 9 + v;
+            columns[3] = 1 + 243 + Board::boxOf(n) * 9 + v;
+            addRow(row, columns);
+        }
+    }
+
+    void DancingLinks::addRow(int row, const int columns[4])
+    {
+        int first = m_nNodes;
+        for (int k = 0; k < 4; k++)
+        {
+            int node = m_nNodes++;
+            int c = columns[k];
+
+            // append at the bottom of the column
+            m_columnOf[node] = (short)c;
+            m_rowOf[node] = (short)row;
+            m_down[node] = (short)c;
+            m_up[node] = m_up[c];
+            m_down[m_up[c]] = (short)node;
+            m_up[c] = (short)node;
+            m_size[c]++;
+
+            // and into the ring of the row
+            m_left[node] = (short)(k == 0 ? first + 3 : node - 1);
+            m_right[node] = (short)(k == 3 ? first : node + 1);
+        }
+    }
+
+    void DancingLinks::cover(int c)
+    {
+        m_right[m_left[c]] = m_right[c];
+        m_left[m_right[c]] = m_left[c];
+
+        for (int i = m_down[c]; i != c; i = m_down[i])
+        {
+            for (int j = m_right[i]; j != i; j = m_right[j])
+            {
+                m_down[m_up[j]] = m_down[j];
+                m_up[m_down[j]] = m_up[j];
+                m_size[m_columnOf[j]]--;
+            }
+        }
+    }
+
+    void DancingLinks::uncover(int c)
+    {
+        for (int i = m_up[c]; i != c; i = m_up[i])
+        {
+            for (int j = m_left[i]; j != i; j = m_left[j])
+            {
+                m_size[m_columnOf[j]]++;
+                m_down[m_up[j]] = (short)j;
+                m_up[m_down[j]] = (short)j;
+            }
+        }
+
+        m_right[m_left[c]] = (short)c;
+        m_left[m_right[c]] = (short)c;
+    }
+
+    bool DancingLinks::selectRow(int row)
+    {
+        int first = 1 + DLX_COLUMNS + row * 4;
+
+        // all four columns must still be open, or another given already satisfies one of them
+        int node = first;
+        do
+        {
+            int c = m_columnOf[node];
+            if (m_right[m_left[c]] != c)
+                return false;
+            node = m_right[node];
+        } while (node != first);
+
+        node = first;
+        do
+        {
+            cover(m_columnOf[node]);
+            node = m_right[node];
+        } while (node != first);
+
+        m_solution[m_nSolutionDepth++] = (short)first;
+        return true;
+    }
+
+    // Knuth's Algorithm X: take the column with the fewest rows left, and try each of its rows
+    // by covering all the columns the row meets. Every row tried spends a node of the budget.
+    //
+    bool DancingLinks::search(int depth, SearchBudget* pBudget)
+    {
+        if (m_right[DLX_ROOT] == DLX_ROOT)
+        {
+            m_nSolutionDepth = depth;
+            return true;
+        }
+
+        int c = m_right[DLX_ROOT];
+        for (int k = m_right[c]; k != DLX_ROOT; k = m_right[k])
+        {
+            if (m_size[k] < m_size[c])
+                c = k;
+        }
+        KSUDOKU_COUNT(m_stats.nBranches++);
+        KSUDOKU_COUNT(m_stats.nCandidates += m_size[c]);
+        if (m_size[c] == 0)
+            return false;
+
+        cover(c);
+        for (int r = m_down[c]; r != c; r = m_down[r])
+        {
+            if (pBudget && pBudget->spend())
+                break;
+
+            m_solution[depth] = (short)r;
+            KSUDOKU_COUNT(m_stats.nNodes++);
+            for (int j = m_right[r]; j != r; j = m_right[j])
+                cover(m_columnOf[j]);
+
+            if (search(depth + 1, pBudget))
+                return true;
+
+            for (int j = m_left[r]; j != r; j = m_left[j])
+                uncover(m_columnOf[j]);
+            KSUDOKU_COUNT(m_stats.nBacktracks++);
+        }
+        uncover(c);
+
+        return false;
+    }
+
+    // Algorithm:
+    //
+    // 1. Build the 729 x 324 exact cover matrix of an empty sudoku as dancing links.
+    // 2. Take the rows of the const cells into the solution, covering their columns.
+    // 3. Search the rest with Algorithm X, and fill the board from the rows taken.
+    //
+    bool SearchDLX(Board& board, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        DancingLinks links;
+        {
+            PhaseTimer timer(pStats, PHASE_PREPARE);
+            links.build();
+
+            for (int n = 0; n < Board::CELLS; n++)
+            {
+                if (board.isGiven(n) && !links.selectRow(n * 9 + board.value(n) - 1))
+                    return false;
+            }
+        }
+
+        bool bFound;
+        {
+            PhaseTimer timer(pStats, PHASE_SEARCH);
+            bFound = links.search(links.solutionDepth(), pBudget);
+        }
+        if (pStats)
+            pStats->add(links.stats());
+        if (!bFound)
+            return false;
+
+        for (int k = 0; k < links.solutionDepth(); k++)
+        {
+            int row = links.solutionRow(k);
+            int n = row / 9;
+            if (!board.isGiven(n))
+                board.place(n, row % 9 + 1);
+        }
+
+        return true;
+    }
+
+}
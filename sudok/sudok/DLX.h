@@ -0,0 +1,12 @@
+#pragma once
+
+namespace KSudoku {
+    template <int BoxSize> class BasicBoard;
+    typedef BasicBoard<3> Board;
+    struct SearchStats;
+    class SearchBudget;
+
+    // fills the board without printing, false if there is no solution or the budget ran out,
+    // pBudget and pStats may be NULL
+    bool SearchDLX(Board& board, SearchBudget* pBudget, SearchStats* pStats);
+}
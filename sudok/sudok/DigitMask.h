@@ -0,0 +1,45 @@
+#pragma once
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace KSudoku {
+
+    // a set of sudoku digits, bit (v - 1) stands for digit v
+    typedef unsigned short DigitMask;
+
+    const DigitMask ALL_DIGITS = 0x1FF;
+
+    inline DigitMask DigitToMask(int v)
+    {
+        return (DigitMask)(1 << (v - 1));
+    }
+
+    // the digit of the lowest bit set in a non-empty mask, wider masks of up to 32 digits work as well
+    inline int LowestDigit(unsigned int mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (int)index + 1;
+#else
+        return __builtin_ctz(mask) + 1;
+#endif
+    }
+
+    inline int CountDigits(unsigned int mask)
+    {
+#ifdef _MSC_VER
+        // __popcnt would need a POPCNT capable CPU, so count the bits by hand
+        unsigned int n = mask;
+        n = n - ((n >> 1) & 0x55555555);
+        n = (n & 0x33333333) + ((n >> 2) & 0x33333333);
+        n = (n + (n >> 4)) & 0x0F0F0F0F;
+        return (int)((n * 0x01010101) >> 24);
+#else
+        return __builtin_popcount(mask);
+#endif
+    }
+
+}
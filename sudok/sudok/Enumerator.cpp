@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "Enumerator.h"
+#include "Propagation.h"
+#include "Archive.h"
+#include <stdio.h>
+
+namespace KSudoku {
+
+    SolutionEnumerator::SolutionEnumerator()
+        : m_search(m_board), m_nSolutions(0), m_bPending(false), m_bStarted(false)
+    {
+    }
+
+    // The singles are filled first, they hold in every solution so none is lost, and the mrv
+    // search walks the rest. The first solution is looked for right away to tell whether
+    // there is any.
+    //
+    SolveStatus SolutionEnumerator::start(const char puzzle[81], SearchBudget* pBudget, SearchStats* pStats)
+    {
+        m_nSolutions = 0;
+        m_bPending = false;
+        m_bStarted = false;
+        if (!puzzle)
+            return SOLVE_INVALID_ARGUMENT;
+        if (!LoadBoard(m_board, puzzle))
+            return SOLVE_INVALID_PUZZLE;
+        if (!Propagate(m_board))
+            return SOLVE_NO_SOLUTION;
+
+        m_search.reset();
+        m_bStarted = true;
+        m_bPending = m_search.next(pBudget, pStats);
+        if (m_search.stopped())
+            return StoppedStatus(pBudget->reason());
+        return m_bPending ? SOLVE_SOLVED : SOLVE_NO_SOLUTION;
+    }
+
+    bool SolutionEnumerator::next(char solution[81], SearchBudget* pBudget, SearchStats* pStats)
+    {
+        if (!m_bStarted)
+            return false;
+
+        if (m_bPending)
+            m_bPending = false;
+        else if (!m_search.next(pBudget, pStats))
+            return false;
+
+        StoreBoard(m_board, solution);
+        m_nSolutions++;
+        return true;
+    }
+
+    long long EnumerateSolutions(const char puzzle[81], const char* outputFileName, long long nLimit,
+                                 bool bCompress, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        SolutionEnumerator enumerator;
+        SolveStatus status;
+        {
+            PhaseTimer timer(pStats, PHASE_SEARCH);
+            status = enumerator.start(puzzle, pBudget, pStats);
+        }
+        if (status == SOLVE_INVALID_PUZZLE || status == SOLVE_INVALID_ARGUMENT)
+        {
+            fprintf(stderr, "the puzzle is invalid\n");
+            return -1;
+        }
+
+        FILE* output = stdout;
+        ArchiveWriter archive;
+        bool bArchive = IsArchiveFileName(outputFileName);
+        if (bArchive)
+        {
+            if (!archive.open(outputFileName, ARCHIVE_SOLUTIONS, bCompress))
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+        }
+        else if (outputFileName)
+        {
+            output = fopen(outputFileName, "w");
+            if (!output)
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+        }
+        if (!bArchive)
+            setvbuf(output, NULL, _IOFBF, 1 << 16);
+
+        // each solution is written before the next is looked for, nothing piles up
+        bool bFailed = false;
+        char solution[81];
+        char line[82];
+        line[81] = '\n';
+        while ((nLimit == 0 || enumerator.count() < nLimit) && !bFailed)
+        {
+            bool bFound;
+            {
+                PhaseTimer timer(pStats, PHASE_SEARCH);
+                bFound = enumerator.next(solution, pBudget, pStats);
+            }
+            if (!bFound)
+                break;
+
+            if (bArchive)
+            {
+                bFailed = !archive.write(solution);
+            }
+            else
+            {
+                for (int i = 0; i < 81; i++)
+                    line[i] = (char)('0' + solution[i]);
+                bFailed = fwrite(line, 1, sizeof(line), output) != sizeof(line);
+            }
+        }
+
+        if (bArchive)
+            bFailed = !archive.close() || bFailed;
+        else if (output != stdout)
+            bFailed = fclose(output) != 0 || bFailed;
+        else
+            bFailed = fflush(output) != 0 || bFailed;
+        if (bFailed)
+        {
+            fprintf(stderr, "can't write %s\n", outputFileName ? outputFileName : "the solutions");
+            return -1;
+        }
+        return enumerator.count();
+    }
+
+}
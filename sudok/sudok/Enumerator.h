@@ -0,0 +1,50 @@
+#pragma once
+#include "Board.h"
+#include "BasicMRV.h"
+#include "Solver.h"
+
+namespace KSudoku {
+
+    // Walks the solutions of a puzzle one at a time: each call to next() resumes the search
+    // where the last solution left it, so the caller decides how many to take and may stop at
+    // any point. It holds a board and the trail of the search, about 1KB whatever the number
+    // of solutions, and never allocates.
+    //
+    //   SolutionEnumerator enumerator;
+    //   if (enumerator.start(puzzle, NULL, NULL) == SOLVE_SOLVED)
+    //       while (enumerator.next(solution, NULL, NULL))
+    //           ...
+    //
+    class SolutionEnumerator {
+    public:
+        SolutionEnumerator();
+
+        // Fills the singles of the puzzle and sets the search up at its first solution.
+        // SOLVE_SOLVED means there is at least one to take, next() takes it. pBudget may be NULL.
+        SolveStatus start(const char puzzle[81], SearchBudget* pBudget, SearchStats* pStats);
+
+        // the next solution into solution, false when there is none left or the budget ran out,
+        // the search can't go on after that
+        bool        next(char solution[81], SearchBudget* pBudget, SearchStats* pStats);
+
+        long long   count() const   { return m_nSolutions; }    // the solutions taken so far
+
+    private:
+        SolutionEnumerator(const SolutionEnumerator&);
+        SolutionEnumerator& operator=(const SolutionEnumerator&);
+
+    private:
+        Board               m_board;
+        BasicMRVSearch<3>   m_search;       // runs on m_board
+        long long           m_nSolutions;
+        bool                m_bPending;     // the first solution is found and not taken yet
+        bool                m_bStarted;
+    };
+
+    // Writes the solutions of the puzzle to the output file (stdout if NULL) as they are found,
+    // one line of 81 digits each, or as a solutions archive if the file is named *.ksa. Stops
+    // after nLimit of them unless nLimit is 0, or when the budget runs out. Returns the number
+    // written, -1 if the puzzle is invalid or the file can't be written.
+    long long EnumerateSolutions(const char puzzle[81], const char* outputFileName, long long nLimit,
+                                 bool bCompress, SearchBudget* pBudget, SearchStats* pStats);
+}
@@ -0,0 +1,232 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "BasicMRV.h"
+#include "Propagation.h"
+#include "ThreadPool.h"
+#include "Generator.h"
+#include "Archive.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace KSudoku {
+
+    const int GENERATOR_CHUNK_SIZE = 1024;      // puzzles generated ahead of the writing
+    const int GENERATOR_CHUNKS_IN_FLIGHT = 2;
+    const int GENERATOR_MAX_ATTEMPTS = 64;      // full grids tried for one puzzle
+
+    struct GeneratorChunk {
+        GeneratorChunk() : lines(GENERATOR_CHUNK_SIZE * 82), nPuzzles(0), nClues(0) {}
+
+        std::vector<char>       lines;          // 82 characters per puzzle, "\n" included
+        int                     nPuzzles;
+        long long               nFirstPuzzle;
+        std::atomic<long long>  nClues;
+        TaskGroup               group;
+    };
+
+    // a random full grid: the three sub-regions on the diagonal don't see each other, so they
+    // take random permutations, and the mrv search fills in the rest
+    void RandomFullBoard(std::mt19937& random, Board& board)
+    {
+        board.clear();
+
+        int digits[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        for (int b = 0; b < 3; b++)
+        {
+            std::shuffle(digits, digits + 9, random);
+            for (int k = 0; k < 9; k++)
+                board.place((b * 3 + k / 3) * 9 + b * 3 + k % 3, digits[k]);
+        }
+
+        SearchBoardMRV<3>(board, nullptr, nullptr);
+    }
+
+    bool IsSolvedBySingles(const Board& board)
+    {
+        Board copy = board;
+        return Propagate(copy) && VerifySolution(copy);
+    }
+
+    // Removes the clues of a full board in random order, keeping only the removals after which
+    // the puzzle still has a unique solution (and for easy puzzles is still solved by singles).
+    // Returns the number of clues left.
+    //
+    int RemoveClues(std::mt19937& random, const GeneratorOptions& options, Board& puzzle)
+    {
+        int order[81];
+        for (int n = 0; n < 81; n++)
+            order[n] = n;
+        std::shuffle(order, order + 81, random);
+
+        int nClues = 81;
+        for (int k = 0; k < 81 && nClues > options.nTargetClues; k++)
+        {
+            int n = order[k];
+            int v = puzzle.value(n);
+            puzzle.remove(n);
+
+            // the uniqueness check: stop the count at a second solution
+            Board trial = puzzle;
+            bool bKeep = CountBoardSolutions<3>(trial, 2, nullptr, nullptr) == 1;
+            if (bKeep && options.difficulty == DIFFICULTY_EASY)
+                bKeep = IsSolvedBySingles(puzzle);
+
+            if (bKeep)
+                nClues--;
+            else
+                puzzle.place(n, v);
+        }
+
+        return nClues;
+    }
+
+    // Generates puzzle nPuzzle into line, returns its number of clues. If no attempt meets the
+    // target clue count or the difficulty, the attempt closest to the target is taken.
+    //
+    int GeneratePuzzle(const GeneratorOptions& options, long long nPuzzle, char line[82])
+    {
+        std::seed_seq seq = { options.seed, (unsigned int)nPuzzle, (unsigned int)(nPuzzle >> 32) };
+        std::mt19937 random(seq);
+
+        Board best;
+        int nBestClues = 82;
+        for (int nAttempt = 0; nAttempt < GENERATOR_MAX_ATTEMPTS; nAttempt++)
+        {
+            Board puzzle;
+            RandomFullBoard(random, puzzle);
+            int nClues = RemoveClues(random, options, puzzle);
+
+            bool bDifficultyMet = options.difficulty != DIFFICULTY_HARD || !IsSolvedBySingles(puzzle);
+            if (bDifficultyMet && nClues < nBestClues)
+            {
+                best = puzzle;
+                nBestClues = nClues;
+            }
+            if (bDifficultyMet && (options.nTargetClues == 0 || nClues <= options.nTargetClues))
+                break;
+            if (nBestClues == 82 && nAttempt == GENERATOR_MAX_ATTEMPTS - 1)
+            {
+                best = puzzle;          // never met the difficulty, take the last one anyway
+                nBestClues = nClues;
+            }
+        }
+
+        for (int n = 0; n < 81; n++)
+            line[n] = best.value(n) ? (char)('0' + best.value(n)) : '.';
+        line[81] = '\n';
+
+        return nBestClues;
+    }
+
+    // writes the puzzle lines of a chunk to a puzzles archive
+    void WriteToArchive(ArchiveWriter& archive, const GeneratorChunk& chunk)
+    {
+        char cells[81];
+        for (int k = 0; k < chunk.nPuzzles; k++)
+        {
+            const char* line = &chunk.lines[k * 82];
+            for (int n = 0; n < 81; n++)
+                cells[n] = line[n] == '.' ? 0 : (char)(line[n] - '0');
+            archive.write(cells);
+        }
+    }
+
+    // The puzzles are generated in chunks on the work-stealing pool, and the chunks are written
+    // in order as they complete.
+    //
+    int GeneratePuzzles(const GeneratorOptions& options, const char* outputFileName)
+    {
+        FILE* output = stdout;
+        ArchiveWriter archive;
+        bool bArchive = IsArchiveFileName(outputFileName);
+        if (bArchive)
+        {
+            if (!archive.open(outputFileName, ARCHIVE_PUZZLES, options.bCompress))
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+            output = nullptr;
+        }
+        else if (outputFileName)
+        {
+            output = fopen(outputFileName, "w");
+            if (!output)
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+        }
+        if (output)
+            setvbuf(output, NULL, _IOFBF, 1 << 16);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        WorkStealingPool pool(options.nThreads);
+        std::unique_ptr<GeneratorChunk> chunks[GENERATOR_CHUNKS_IN_FLIGHT];
+        for (int i = 0; i < GENERATOR_CHUNKS_IN_FLIGHT; i++)
+            chunks[i].reset(new GeneratorChunk());
+
+        long long nClues = 0;
+        long long nNext = 0;            // the first puzzle not handed out yet
+        long long nSubmitted = 0;
+        long long nWritten = 0;
+        while (nWritten < nSubmitted || nNext < options.nPuzzles)
+        {
+            if (nSubmitted - nWritten == GENERATOR_CHUNKS_IN_FLIGHT || nNext == options.nPuzzles)
+            {
+                GeneratorChunk& done = *chunks[nWritten % GENERATOR_CHUNKS_IN_FLIGHT];
+                done.group.wait();
+                if (bArchive)
+                    WriteToArchive(archive, done);
+                else
+                    fwrite(&done.lines[0], 1, done.nPuzzles * 82, output);
+                nClues += done.nClues;
+                nWritten++;
+                continue;
+            }
+
+            GeneratorChunk& chunk = *chunks[nSubmitted % GENERATOR_CHUNKS_IN_FLIGHT];
+            long long nLeft = options.nPuzzles - nNext;
+            chunk.nPuzzles = nLeft < GENERATOR_CHUNK_SIZE ? (int)nLeft : GENERATOR_CHUNK_SIZE;
+            chunk.nFirstPuzzle = nNext;
+            chunk.nClues = 0;
+            for (int k = 0; k < chunk.nPuzzles; k++)
+            {
+                GeneratorChunk* pChunk = &chunk;
+                pool.submit(chunk.group, [&options, pChunk, k](int) {
+                    int n = GeneratePuzzle(options, pChunk->nFirstPuzzle + k, &pChunk->lines[k * 82]);
+                    pChunk->nClues += n;
+                });
+            }
+            nNext += chunk.nPuzzles;
+            nSubmitted++;
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (bArchive)
+        {
+            if (!archive.close())
+            {
+                fprintf(stderr, "can't write %s\n", outputFileName);
+                return -1;
+            }
+        }
+        else if (output != stdout)
+            fclose(output);
+        else
+            fflush(output);
+
+        fprintf(stderr, "%lld puzzles, %.1f clues on average in %.3f s with %d threads, %.0f puzzles/second\n",
+            options.nPuzzles, options.nPuzzles > 0 ? (double)nClues / options.nPuzzles : 0.0,
+            seconds, pool.numWorkers(), seconds > 0 ? options.nPuzzles / seconds : 0.0);
+
+        return 0;
+    }
+
+}
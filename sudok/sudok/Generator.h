@@ -0,0 +1,25 @@
+#pragma once
+
+namespace KSudoku {
+
+    enum Difficulty {
+        DIFFICULTY_ANY,
+        DIFFICULTY_EASY,        // solved by naked and hidden singles alone
+        DIFFICULTY_HARD         // needs search after the singles
+    };
+
+    struct GeneratorOptions {
+        long long       nPuzzles;
+        int             nTargetClues;   // stop removing clues at this count, 0 to remove all it can
+        Difficulty      difficulty;
+        unsigned int    seed;
+        int             nThreads;
+        bool            bCompress;      // compress the blocks of an archive output file
+    };
+
+    // Generates puzzles with a unique solution and writes them one per line to the output file
+    // (stdout if NULL), "." for the cells to be filled, or to a puzzles archive if the file is
+    // named *.ksa. Puzzle k only depends on the seed and k, so the output is the same for any
+    // number of threads. Returns -1 if the file can't be opened.
+    int GeneratePuzzles(const GeneratorOptions& options, const char* outputFileName);
+}
@@ -0,0 +1,136 @@
+#include "stdafx.h"
+#include "BasicBoard.h"
+#include "BasicMRV.h"
+#include "BasicPropagation.h"
+#include "Generic.h"
+#include "SearchBudget.h"
+#include "SearchStats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace KSudoku {
+
+    template <int BoxSize>
+    void PrintBoard(const BasicBoard<BoxSize>& board)
+    {
+        typedef BasicBoard<BoxSize> B;
+        for (int i = 0; i < B::SIZE; i++)
+        {
+            for (int j = 0; j < B::SIZE; j++)
+            {
+                printf(B::SIZE > 9 ? "%2d " : "%d ", board.value(i * B::SIZE + j));
+                if ((j + 1) % BoxSize == 0)
+                {
+                    printf(" ");
+                }
+            }
+            if ((i + 1) % BoxSize == 0)
+            {
+                printf("\n");
+            }
+            printf("\n");
+        }
+    }
+
+    template <int BoxSize>
+    bool SolveGeneric(const std::vector<int>& numbers, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        typedef BasicBoard<BoxSize> B;
+        if ((int)numbers.size() != B::CELLS)
+        {
+            printf("the input file is illegal\n");
+            return false;
+        }
+
+        B board;
+        for (int n = 0; n < B::CELLS; n++)
+        {
+            int v = numbers[n];
+            if (v < 0 || v > B::SIZE || (v > 0 && !(board.candidates(n) & B::maskOf(v))))
+            {
+                printf("the input file is illegal\n");
+                return false;
+            }
+            if (v > 0)
+                board.place(n, v);
+        }
+
+        printf("the original %dx%d table is...\n\n", B::SIZE, B::SIZE);
+        PrintBoard(board);
+
+        // the singles first, as in the other modes
+        bool b;
+        {
+            PhaseTimer timer(pStats, PHASE_PREPARE);
+            b = PropagateBoard<BoxSize>(board);
+        }
+        if (b)
+        {
+            PhaseTimer timer(pStats, PHASE_SEARCH);
+            b = SearchBoardMRV<BoxSize>(board, pBudget, pStats) && VerifyBoard(board);
+        }
+        if (pBudget->stopped())
+        {
+            printf("we give up: %s\n", SearchStopName(pBudget->reason()));
+        }
+        else if (b)
+        {
+            printf("we find a solutions!\n");
+            PrintBoard(board);
+        }
+        else
+        {
+            printf("we don't find a solution\n");
+        }
+
+        return b;
+    }
+
+    bool SolveGenericFile(const char* fileName, long long nTimeoutMs, unsigned long long nMaxNodes,
+                          SearchStats* pStats)
+    {
+        std::vector<int> numbers;
+        int nPerRow = 0;
+        {
+            PhaseTimer timer(pStats, PHASE_PARSE);
+            std::ifstream file(fileName);
+            std::string str;
+            while (std::getline(file, str))
+            {
+                std::istringstream line(str);
+                int v;
+                int nInLine = 0;
+                while (line >> v)
+                {
+                    numbers.push_back(v);
+                    nInLine++;
+                }
+                if (nPerRow == 0)
+                    nPerRow = nInLine;
+            }
+        }
+
+        // the time limit starts once the file is read
+        SearchLimits limits = nTimeoutMs > 0 ? SearchLimitsIn(nTimeoutMs) : NoSearchLimits();
+        limits.nMaxNodes = nMaxNodes;
+        SearchBudget budget(limits);
+
+        switch (nPerRow)
+        {
+        case 9:
+            return SolveGeneric<3>(numbers, &budget, pStats);
+        case 16:
+            return SolveGeneric<4>(numbers, &budget, pStats);
+        case 25:
+            return SolveGeneric<5>(numbers, &budget, pStats);
+        default:
+            printf("the input file is illegal\n");
+            return false;
+        }
+    }
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace KSudoku {
+    struct SearchStats;
+
+    // Solves a sudoku file of any supported size, 9x9, 16x16 or 25x25, written like the 9x9 one:
+    // one line per row with the numbers separated by spaces, "0" for the cells to be filled.
+    // The size is taken from the numbers of the first line. The search gives up after nTimeoutMs
+    // milliseconds from the end of the reading or nMaxNodes nodes, 0 for no limit. Returns false
+    // if there is no solution or the search gave up. pStats may be NULL.
+    bool SolveGenericFile(const char* fileName, long long nTimeoutMs, unsigned long long nMaxNodes,
+                          SearchStats* pStats);
+}
@@ -2,7 +2,15 @@
 //
 // This program generates a solution for a 9X9 sudoku game.
 //
-// Usage: ksudoku.exe <sudoku_file.txt>
+// Usage: ksudoku.exe <sudoku_file.txt> [mode] [--threads N] [--limit N] [--timeout MS] [--max-nodes N] [--stats]
+//        ksudoku.exe <sudoku_file.txt> enumerate [solutions_file.txt] [--limit N] [--timeout MS] [--max-nodes N] [--compress] [--stats]
+//        ksudoku.exe <puzzles_file.txt> batch [solutions_file.txt] [--threads N] [--cache N] [--timeout MS] [--max-nodes N] [--compress] [--stats]
+//        ksudoku.exe <puzzles_file.txt> portfolio [solutions_file.txt] [--configs LIST] [--timeout MS] [--max-nodes N] [--stats]
+//        ksudoku.exe <solutions_file.txt> validate
+//        ksudoku.exe generate <count> [puzzles_file.txt] [--clues N] [--difficulty easy|hard] [--seed S] [--threads N] [--compress]
+//        ksudoku.exe <puzzles_file.txt> pack <archive.ksa> [--solutions] [--compress]
+//        ksudoku.exe <archive.ksa> unpack [puzzles_file.txt]
+//        ksudoku.exe serve [socket_path] [--threads N] [--cache N] [--queue N] [--timeout MS] [--max-nodes N] [--stats]
 // the sudoku file should be a text file like the following
 //
 // 3 0 0 0 6 7 9 0 0
@@ -15,7 +23,37 @@
 // 0 0 0 4 0 0 0 1 0
 // 0 8 9 0 3 0 0 2 0
 //
-// where "0" is the cell to be filled
+// where "0" is the cell to be filled, or a single line of the 81 cells row by row.
+//
+// The "generic" mode takes 9x9, 16x16 or 25x25 files written the same way, one row per line.
+//
+// In batch mode the puzzles file holds one puzzle per line, 81 characters row by row
+// with "0" or "." for the cells to be filled, and one solution line is written per puzzle.
+// The puzzles are solved on N threads, by default as many as the hardware runs at once.
+// With --cache N the solutions of up to N puzzles are kept and the symmetries of a puzzle
+// already solved are looked up rather than solved again.
+//
+// The portfolio mode races several solver configurations on each puzzle, each on its own
+// thread, takes the first answer and counts the wins of each (see Portfolio.h). LIST is
+// comma separated, "engine" or "engine:seed" for a random symmetry of the puzzle.
+//
+// The enumerate mode writes every solution of the puzzle, or the first N with --limit N,
+// one line each as they are found, without keeping them.
+//
+// The generate mode writes puzzles with a unique solution in the same one line format.
+//
+// The batch, enumerate, validate and generate modes also read and write binary archives (see Archive.h),
+// any file named *.ksa is written as one. pack and unpack convert between the two.
+//
+// The serve mode keeps running and answers puzzles sent one per line with an id, over stdin
+// or a Unix domain socket (see Server.h).
+//
+// With --timeout MS or --max-nodes N the search of a puzzle gives up after that many
+// milliseconds or nodes and the puzzle is reported as timed out, in the batch and serve
+// modes for each puzzle on its own.
+//
+// With --stats the nodes, backtracks and validations of the search and the time of each
+// phase are printed after the solution.
 //
 // Author: 	Kai Zhang
 // Date: 	2014/4/19
@@ -23,33 +61,72 @@
 
 #include "stdafx.h"
 #include <stdio.h>
-#include <fstream>
-#include <string>
-#include "Table.h"
-#include "BackTracking.h"
+#include <stdlib.h>
+#include <chrono>
+#include "Board.h"
+#include "Solver.h"
+#include "Batch.h"
+#include "ThreadPool.h"
+#include "ParallelSearch.h"
+#include "Propagation.h"
+#include "Generic.h"
+#include "Generator.h"
 #include "Permutation.h"
+#include "SearchStats.h"
+#include "PuzzleFile.h"
+#include "Archive.h"
+#include "Server.h"
+#include "Enumerator.h"
+#include "Portfolio.h"
 
 using namespace KSudoku;
 
-Table* createTableFromFile(const char* fileName)
+// reads the first puzzle of the file, written as nine lines or as one line of 81 cells
+bool readPuzzleFromFile(const char* fileName, char cells[81])
 {
-	int a[9][9];	// the sudoku array
+    MappedFile file;
+    if (!file.open(fileName))
+    {
+        printf("can't open %s\n", fileName);
+        return false;
+    }
 
-	std::ifstream file(fileName);
-    std::string str;
-	int i = 0;
-    while (std::getline(file, str))
+    PuzzleParser parser(file.begin(), file.end());
+    ParseResult result = parser.next(cells);
+    if (result == PARSE_END)
     {
-		sscanf_s(str.c_str(), "%d %d %d %d %d %d %d %d %d",
-			&a[i][0], &a[i][1], &a[i][2], &a[i][3], &a[i][4], &a[i][5], &a[i][6], &a[i][7], &a[i][8]);
-		i++;
+        printf("%s has no puzzle\n", fileName);
+        return false;
+    }
+    if (result == PARSE_MALFORMED)
+    {
+        printf("%s line %lld, offset %lld: %s\n", fileName, parser.recordLine(), parser.recordOffset(), parser.error());
+        return false;
     }
 
-	Table* table = Table::createTable(a);
-	return table;
+    return true;
+}
+
+void printResult(bool bSolved, const Board& board)
+{
+    if (bSolved)
+    {
+        printf("we find a solutions!\n");
+        PrintBoard(board);
+    }
+    else
+    {
+        printf("we don't find a solution\n");
+    }
 }
 
 
+// the options followed by a value, the others are flags
+const char* const OPTIONS_WITH_VALUE[] = {
+    "--threads", "--limit", "--cache", "--timeout", "--max-nodes", "--configs", "--queue", "--clues", "--seed",
+    "--difficulty"
+};
+
 int _tmain(int argc, char* argv[])
 {
 	if (argc < 2)
@@ -58,32 +135,281 @@ int _tmain(int argc, char* argv[])
 		return -1;
 	}
 
-	Table* aTable = createTableFromFile(argv[1]);
-	if (!aTable)
+    int nThreads = WorkStealingPool::defaultThreadCount();
+    int nLimit = 2;
+    bool bLimit = false;
+    int nClues = 0;
+    int nMaxPending = 1024;
+    long long nCacheEntries = 0;
+    long long nTimeoutMs = 0;
+    unsigned long long nMaxNodes = 0;
+    unsigned int seed = 1;
+    Difficulty difficulty = DIFFICULTY_ANY;
+    const char* outputFileName = NULL;
+    const char* portfolioConfigs = DEFAULT_PORTFOLIO;
+    bool bStats = false;
+    bool bCompress = false;
+    bool bSolutions = false;
+    // serve takes no second argument, its options start right after it
+    bool bServe = strcmp(argv[1], "serve") == 0;
+    for (int i = bServe ? 2 : 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            nThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc)
+        {
+            nLimit = atoi(argv[++i]);
+            bLimit = true;
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            nCacheEntries = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc)
+            nTimeoutMs = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--max-nodes") == 0 && i + 1 < argc)
+            nMaxNodes = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--configs") == 0 && i + 1 < argc)
+            portfolioConfigs = argv[++i];
+        else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc)
+            nMaxPending = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--clues") == 0 && i + 1 < argc)
+            nClues = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--stats") == 0)
+            bStats = true;
+        else if (strcmp(argv[i], "--compress") == 0)
+            bCompress = true;
+        else if (strcmp(argv[i], "--solutions") == 0)
+            bSolutions = true;
+        else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc)
+        {
+            const char* level = argv[++i];
+            difficulty = strcmp(level, "easy") == 0 ? DIFFICULTY_EASY
+                       : strcmp(level, "hard") == 0 ? DIFFICULTY_HARD : DIFFICULTY_ANY;
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            // a typo or a missing value mustn't end up as the output file
+            bool bKnown = false;
+            for (int k = 0; k < (int)(sizeof(OPTIONS_WITH_VALUE) / sizeof(OPTIONS_WITH_VALUE[0])); k++)
+                bKnown = bKnown || strcmp(argv[i], OPTIONS_WITH_VALUE[k]) == 0;
+            printf(bKnown ? "%s needs a value\n" : "unknown option %s\n", argv[i]);
+            return -1;
+        }
+        else if (!outputFileName)
+            outputFileName = argv[i];
+        else
+        {
+            printf("unexpected argument %s\n", argv[i]);
+            return -1;
+        }
+    }
+
+    SearchStats stats;
+    SearchStats* pStats = bStats ? &stats : NULL;
+
+    if (argc >= 3 && strcmp(argv[1], "generate") == 0)
+    {
+        GeneratorOptions options;
+        options.nPuzzles = atoll(argv[2]);
+        options.nTargetClues = nClues;
+        options.difficulty = difficulty;
+        options.seed = seed;
+        options.nThreads = nThreads;
+        options.bCompress = bCompress;
+        return GeneratePuzzles(options, outputFileName) == 0 ? 0 : -1;
+    }
+
+    if (bServe)
+    {
+        ServeOptions options;
+        options.nThreads = nThreads;
+        options.socketPath = outputFileName;
+        options.nCacheEntries = nCacheEntries > 0 ? (size_t)nCacheEntries : 0;
+        options.nMaxPending = nMaxPending;
+        options.nTimeoutMs = nTimeoutMs;
+        options.nMaxNodes = nMaxNodes;
+        int result = ServePuzzles(options, pStats);
+        if (pStats)
+            stats.print(stderr);
+        return result;
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "batch") == 0)
+    {
+        BatchOptions options;
+        options.nThreads = nThreads;
+        options.bCompress = bCompress;
+        options.nCacheEntries = nCacheEntries > 0 ? (size_t)nCacheEntries : 0;
+        options.nTimeoutMs = nTimeoutMs;
+        options.nMaxNodes = nMaxNodes;
+        int nFailed = SolveBatch(argv[1], outputFileName, options, pStats);
+        if (pStats)
+            stats.print(stderr);
+        return nFailed == 0 ? 0 : -1;
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "portfolio") == 0)
+    {
+        PortfolioOptions options;
+        if (!ParsePortfolioConfigs(portfolioConfigs, options.configs))
+        {
+            printf("unknown configurations %s\n", portfolioConfigs);
+            return -1;
+        }
+        options.nTimeoutMs = nTimeoutMs;
+        options.nMaxNodes = nMaxNodes;
+        int nFailed = SolvePortfolioFile(argv[1], outputFileName, options, pStats);
+        if (pStats)
+            stats.print(stderr);
+        return nFailed == 0 ? 0 : -1;
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "validate") == 0)
+    {
+        int nInvalid = ValidateBatch(argv[1]);
+        return nInvalid == 0 ? 0 : -1;
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "pack") == 0)
+    {
+        if (!outputFileName)
+        {
+            printf("please specify the archive file\n");
+            return -1;
+        }
+        return PackArchive(argv[1], outputFileName, bSolutions ? ARCHIVE_SOLUTIONS : ARCHIVE_PUZZLES, bCompress);
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "unpack") == 0)
+    {
+        return UnpackArchive(argv[1], outputFileName);
+    }
+
+    if (argc >= 3 && strcmp(argv[2], "generic") == 0)
+    {
+        bool b = SolveGenericFile(argv[1], nTimeoutMs, nMaxNodes, pStats);
+        if (pStats)
+            stats.print(stdout);
+        return b ? 0 : -1;
+    }
+
+    char puzzle[81];
+    bool bRead;
+    {
+        PhaseTimer timer(pStats, PHASE_PARSE);
+        bRead = readPuzzleFromFile(argv[1], puzzle);
+    }
+
+    // the time limit starts once the puzzle is read
+    SearchLimits limits = nTimeoutMs > 0 ? SearchLimitsIn(nTimeoutMs) : NoSearchLimits();
+    limits.nMaxNodes = nMaxNodes;
+    SearchBudget budget(limits);
+
+    if (argc >= 3 && strcmp(argv[2], "enumerate") == 0)
+    {
+        if (!bRead)
+            return -1;
+        if (bLimit && nLimit < 1)
+        {
+            printf("the limit should be at least 1\n");
+            return -1;
+        }
+
+        // all of them unless --limit is given, the count mode stops at 2 by default
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        long long nSolutions = EnumerateSolutions(puzzle, outputFileName, bLimit ? nLimit : 0, bCompress, &budget, pStats);
+        if (nSolutions < 0)
+            return -1;
+        fprintf(stderr, "%lld solutions in %.3f s%s%s\n", nSolutions,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+            budget.stopped() ? ", " : "", budget.stopped() ? SearchStopName(budget.reason()) : "");
+        if (pStats)
+            stats.print(stderr);
+        return nSolutions > 0 ? 0 : -1;
+    }
+
+	Board board;
+	if (!bRead || !LoadBoard(board, puzzle))
 	{
 		printf("the input file is illegal\n");
 		return -1;
 	}
 
 	printf("the original table is...\n\n");
-	aTable->print();
+	PrintBoard(board);
 
-    if (argc == 2)
+    // the engines of the library fill the singles themselves, the other modes work on the board
+    const char* mode = argc == 2 ? "backtracking" : argv[2];   // default to backtracking
+    SolveOptions options = DefaultSolveOptions();
+    options.limits = limits;
+    bool bSolved = false;
+    if (FindSolverEngine(mode, options.engine))
+    {
+        char solution[81];
+        SolveStatus status = SolveGrid(puzzle, solution, &options, pStats);
+        bSolved = status == SOLVE_SOLVED;
+        if (bSolved)
+            LoadBoard(board, solution);
+        if (status == SOLVE_SOLVED || status == SOLVE_NO_SOLUTION)
+            printResult(bSolved, board);
+        else
+            printf("we give up: %s\n", SolveStatusName(status));
+    }
+    else if (strcmp(mode, "count") == 0)
     {
-        SolveByBackTracking(*aTable);   // default to backtracking
+        if (nLimit < 1)
+        {
+            printf("the limit should be at least 1\n");
+            return -1;
+        }
+
+        int nSolutions = 0;
+        SolveStatus status = CountGridSolutions(puzzle, nLimit, &nSolutions, &limits, pStats);
+        if (status != SOLVE_SOLVED && status != SOLVE_NO_SOLUTION)
+            printf("we give up: %s\n", SolveStatusName(status));
+        else if (nSolutions == 0)
+            printf("we don't find a solution\n");
+        else if (nSolutions == 1)
+            printf("the solution is unique\n");
+        else if (nSolutions < nLimit)
+            printf("we find %d solutions\n", nSolutions);
+        else
+            printf("we find at least %d solutions\n", nSolutions);
+        bSolved = nSolutions > 0;
     }
-    else if (argc == 3){
-        const char* mode = argv[2];
-        if (strcmp(mode, "backtracking") == 0)
+    else if (strcmp(mode, "permutation") == 0 || strcmp(mode, "parallel") == 0)
+    {
+        bool bPropagated;
         {
-            SolveByBackTracking(*aTable);
+            PhaseTimer timer(pStats, PHASE_PREPARE);
+            bPropagated = Propagate(board);
         }
+
+        if (!bPropagated)
+            printResult(false, board);
         else if (strcmp(mode, "permutation") == 0)
+            bSolved = SolveByPermutation(board, &budget, pStats);
+        else
         {
-            SolveByPermutation(*aTable);
+            bSolved = SearchParallel(board, nThreads, &budget, pStats) && VerifySolution(board);
+            if (budget.stopped())
+                printf("we give up: %s\n", SearchStopName(budget.reason()));
+            else
+                printResult(bSolved, board);
         }
     }
+    else
+    {
+        printf("unknown mode %s\n", mode);
+        return -1;
+    }
+
+    if (pStats)
+    {
+        printf("\nsearch stats\n");
+        stats.print(stdout);
+    }
 
-	delete aTable;
-	return 0;
+	return bSolved ? 0 : -1;
 }
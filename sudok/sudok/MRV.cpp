@@ -0,0 +1,26 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "BasicMRV.h"
+#include "MRV.h"
+#include "SearchStats.h"
+
+namespace KSudoku {
+
+    // Algorithm:
+    //
+    // 1. Among all the null cells pick the one with the fewest candidates (minimum remaining values),
+    //    a cell with a single candidate is forced and a cell with none means we went wrong before.
+    // 2. Fill its lowest candidate and push the cell with the rest of its candidates on the trail.
+    // 3. If a cell has no candidates left, pop the trail back to the last cell which still has some,
+    //    clear the cells on the way, and try its next candidate.
+    //
+    // The trail has a fixed size of 81 entries, so the search needs neither recursion nor
+    // allocation, and undoing a move is only clearing the three digit masks of one cell.
+    //
+    bool SearchMRV(Board& board, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        PhaseTimer timer(pStats, PHASE_SEARCH);
+        return SearchBoardMRV<3>(board, pBudget, pStats);
+    }
+
+}
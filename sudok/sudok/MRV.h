@@ -0,0 +1,12 @@
+#pragma once
+
+namespace KSudoku {
+    struct SearchStats;
+    class SearchBudget;
+    template <int BoxSize> class BasicBoard;
+    typedef BasicBoard<3> Board;
+
+    // fills the board without printing, false if there is no solution or the budget ran out,
+    // pBudget and pStats may be NULL
+    bool SearchMRV(Board& board, SearchBudget* pBudget, SearchStats* pStats);
+}
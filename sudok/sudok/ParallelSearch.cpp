@@ -0,0 +1,170 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "BasicMRV.h"
+#include "ThreadPool.h"
+#include "ParallelSearch.h"
+#include "SearchBudget.h"
+#include "SearchStats.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace KSudoku {
+
+    // about this many subtrees per thread are handed out, enough for stealing to even out the work
+    const int SUBTREES_PER_THREAD = 64;
+
+    struct ParallelSearchState {
+        ParallelSearchState(int nThreads, const SearchLimits& searchLimits)
+            : pool(nThreads), limits(searchLimits), nNodes(0), stop(STOP_NONE), bFound(false),
+              workerStats(pool.numWorkers())
+        {
+        }
+
+        WorkStealingPool                pool;
+        TaskGroup                       group;
+        SearchLimits                    limits;         // of the whole search, every subtree spends from them
+        std::atomic<unsigned long long> nNodes;         // the nodes of all the subtrees
+        std::atomic<SearchStop>         stop;           // set by the first subtree which gives up or finds a solution
+        std::atomic<bool>               bFound;         // raised by the first subtree which finds a solution
+        Board                           solution;       // written only by that subtree
+        std::vector<SearchStats>        workerStats;    // each worker adds its subtrees to its own
+    };
+
+    void SearchSubtree(ParallelSearchState& state, const Board& root, int nBudget, int nWorker);
+
+    // Algorithm:
+    //
+    // 1. Fill the forced cells, then take the null cell with the fewest candidates (minimum
+    //    remaining values) and make one copy of the board per candidate: these are the subtrees.
+    // 2. Each subtree is a task for the work-stealing pool, and goes on splitting the same way
+    //    as long as it has a share of the subtree budget left.
+    // 3. A subtree without budget runs the sequential mrv search on its own board.
+    // 4. The first subtree which finds a solution raises a shared flag, and all the others
+    //    see it within a thousand steps and give up.
+    //
+    // The subtrees spend the budget together, the first one to run out stops the others.
+    //
+    bool SearchParallel(Board& board, int nThreads, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        // starting the worker threads is a good part of the time on an easy puzzle
+        std::unique_ptr<ParallelSearchState> pState;
+        {
+            PhaseTimer timer(pStats, PHASE_PREPARE);
+            pState.reset(new ParallelSearchState(nThreads, pBudget ? pBudget->limits() : NoSearchLimits()));
+        }
+
+        ParallelSearchState& state = *pState;
+        {
+            PhaseTimer timer(pStats, PHASE_SEARCH);
+            int nBudget = SUBTREES_PER_THREAD * state.pool.numWorkers();
+            state.pool.submit(state.group, [&state, board, nBudget](int nWorker) {
+                SearchSubtree(state, board, nBudget, nWorker);
+            });
+            state.group.wait();
+        }
+
+        if (pStats)
+        {
+            for (size_t k = 0; k < state.workerStats.size(); k++)
+                pStats->add(state.workerStats[k]);
+        }
+        if (!state.bFound.load())
+        {
+            if (pBudget && state.stop.load() != STOP_NONE)
+                pBudget->stop(state.stop.load());
+            return false;
+        }
+
+        board = state.solution;
+        return true;
+    }
+
+    void FoundSolution(ParallelSearchState& state, const Board& board)
+    {
+        bool bExpected = false;
+        if (state.bFound.compare_exchange_strong(bExpected, true))
+        {
+            state.solution = board;
+            SearchStop none = STOP_NONE;
+            state.stop.compare_exchange_strong(none, STOP_CANCELLED);
+        }
+    }
+
+    void SearchSubtree(ParallelSearchState& state, const Board& root, int nBudget, int nWorker)
+    {
+        if (state.stop.load(std::memory_order_relaxed) != STOP_NONE)
+            return;
+
+        Board board = root;
+        SearchStats& stats = state.workerStats[nWorker];
+        SearchBudget budget(state.limits, &state.nNodes, &state.stop);
+
+        // fill the forced cells until we reach a cell with a choice
+        int best;
+        int bestCount;
+        DigitMask bestMask;
+        for (;;)
+        {
+            best = -1;
+            bestCount = 10;
+            bestMask = 0;
+            for (int n = 0; n < 81; n++)
+            {
+                if (board.value(n) != 0)
+                    continue;
+
+                DigitMask mask = board.candidates(n);
+                int count = CountDigits(mask);
+                if (count < bestCount)
+                {
+                    best = n;
+                    bestCount = count;
+                    bestMask = mask;
+                    if (count <= 1)
+                        break;
+                }
+            }
+
+            if (best < 0)
+                FoundSolution(state, board);    // no null cell left
+            if (bestCount != 1)
+                break;                          // a choice, or a dead end when there is no candidate
+            if (budget.spend())
+                return;
+
+            board.place(best, LowestDigit(bestMask));
+            KSUDOKU_COUNT(stats.nNodes++);
+        }
+
+        if (best >= 0 && bestCount > 1)
+        {
+            KSUDOKU_COUNT(stats.nBranches++);
+            KSUDOKU_COUNT(stats.nCandidates += bestCount);
+            int nChildBudget = nBudget / CountDigits(bestMask);
+            if (nChildBudget < 1)
+            {
+                if (SearchBoardMRV<3>(board, &budget, &stats))
+                    FoundSolution(state, board);
+            }
+            else
+            {
+                while (bestMask && !budget.spend())
+                {
+                    Board child = board;
+                    child.place(best, LowestDigit(bestMask));
+                    bestMask &= bestMask - 1;
+                    KSUDOKU_COUNT(stats.nNodes++);
+
+                    state.pool.submit(state.group, [&state, child, nChildBudget](int nWorker) {
+                        SearchSubtree(state, child, nChildBudget, nWorker);
+                    });
+                }
+            }
+        }
+
+        // the nodes since the last look count against the limit of the others
+        budget.flush();
+    }
+
+}
@@ -1,96 +1,109 @@
 #include "stdafx.h"
-#include "Table.h"
-#include "BackTracking.h"
+#include "Board.h"
+#include "Permutation.h"
+#include "SearchBudget.h"
+#include "SearchStats.h"
 #include <stdio.h>
+#include <algorithm>
 #include <vector>
-#include <tuple>
 
 namespace KSudoku {
 
     class CellValue {
     public:
-        CellValue(Cell* pCell, const ValueList& valueList);
-        bool takeNextPossibleValue();
-        void takeCurrentPossibleValue();
-        Cell* cell() const        { return m_pCell; }
-        int currentValue() const  { return m_possibleValues[m_curentValueIndex]; }
+        CellValue(int nCell, DigitMask possibleValues);
+        int cell() const                        { return m_nCell; }
+        DigitMask possibleValues() const        { return m_possibleValues; }
 
     private:
-        Cell*               m_pCell;
-        ValueList           m_possibleValues;
-        int                 m_curentValueIndex;
+        int                 m_nCell;
+        DigitMask           m_possibleValues;
     };
 
     typedef std::vector<CellValue> CellValueList;
 
-    CellValue::CellValue(Cell* pCell, const ValueList& valueList)
-        : m_pCell(pCell), m_possibleValues(valueList), m_curentValueIndex(0)
+    CellValue::CellValue(int nCell, DigitMask possibleValues)
+        : m_nCell(nCell), m_possibleValues(possibleValues)
     {
     }
 
-    bool CellValue::takeNextPossibleValue()
-    {
-        m_curentValueIndex++;
-
-        bool bCurrentIndexValid = false;
-        if (m_curentValueIndex < (int) m_possibleValues.size())
-            bCurrentIndexValid = true;
-        else
-        {
-            m_curentValueIndex = 0;     // reset to 0
-            bCurrentIndexValid = false;
-        }
-
-        m_pCell->setValue(m_possibleValues[m_curentValueIndex]);
-        return bCurrentIndexValid;
-    }
+    // the digits of three rows (or columns) of a sub-region, row k in bits 9k ~ 9k+8, so two
+    // sub-regions side by side fit together when their packed row masks share no bit
+    typedef unsigned int                    PackedMasks;
+
+    // the three lines of a sub-region solution hold every digit once, so the lines of the third
+    // sub-region next to two which fit are all the digits the two leave out, ALL_LINES ^ a ^ b
+    const PackedMasks ALL_LINES = ALL_DIGITS | ALL_DIGITS << 9 | ALL_DIGITS << 18;
+
+    // A run of solutions sharing a key in a list sorted on it. In the last level of an index
+    // first and count pick the solutions, in the levels above the groups of the next level.
+    //
+    struct KeyGroup {
+        PackedMasks         key;
+        unsigned int        first;
+        unsigned int        count;
+    };
+    typedef std::vector<KeyGroup>           KeyGroupList;
 
-    void CellValue::takeCurrentPossibleValue()
+    // the group of the key among groups[first, first + count), NULL if there is none
+    const KeyGroup* FindGroup(const KeyGroupList& groups, unsigned first, unsigned count, PackedMasks key)
     {
-        m_pCell->setValue(m_possibleValues[m_curentValueIndex]);
+        const KeyGroup* pEnd = groups.data() + first + count;
+        const KeyGroup* pGroup = std::lower_bound(groups.data() + first, pEnd, key,
+            [](const KeyGroup& group, PackedMasks k) { return group.key < k; });
+        return pGroup != pEnd && pGroup->key == key ? pGroup : NULL;
     }
 
-    typedef std::vector<int>                SubRegionSolution;
+    // A sub-region solution packs the values of its null cells in 4 bits each, the k-th null
+    // cell in bits 4k ~ 4k+3, next to the row and column masks of the whole sub-region.
+    // The solutions of a sub-region then sit in one contiguous array of 16 byte entries.
+    //
+    struct SubRegionSolution {
+        unsigned long long  values;
+        PackedMasks         rows;
+        PackedMasks         columns;
+    };
     typedef std::vector<SubRegionSolution>  SubRegionSolutionList;
 
     class SubRegion {
     public:
         SubRegion();
-        void setTable(Table* pTable);
+        void setBoard(Board* pBoard);
         void setBaseCoordinate(int x, int y);
         void addCellValue(const CellValue& cv);
 
-        bool solveByPermutation();
-        bool verify();
-
-        void takeCurrentSolution();
-        int  currentSolutionIndex()             { return m_currentSolutionIndex; }
-        void setCurrentSolutionIndex(int n)     { m_currentSolutionIndex = n; }
-        bool takeNextSolution();
+        bool solveByPermutation(SearchBudget* pBudget);
+        void indexByRows();
 
-        int numOfSolutions() const { return (int) m_solutions.size(); }
+        void        clearSolution();
+        void        takeSolution(int n);
+        int         numOfSolutions() const      { return (int) m_solutions.size(); }
+        PackedMasks columnMasks(int n) const    { return m_solutions[n].columns; }
+        const KeyGroupList& rowGroups() const   { return m_rowGroups; }
+        const SearchStats& stats() const        { return m_stats; }
 
     private:
-        static bool GetNextPermutation(CellValueList& cellValueList);
-        void addSubRegionSolution();
+        void placeCellValues(size_t k, DigitMask used, const SubRegionSolution& partial, SearchBudget* pBudget);
+        size_t maxNumOfSolutions() const;
     private:
-        Table*                  m_pTable;
+        Board*                  m_pBoard;
         int                     m_baseX;
         int                     m_baseY;
         CellValueList           m_cellValueList;
         SubRegionSolutionList   m_solutions;
-        int                     m_currentSolutionIndex;
+        KeyGroupList            m_rowGroups;    // the solutions sharing their row masks
+        SearchStats             m_stats;        // a node is a value placed by placeCellValues
     };
 
     SubRegion::SubRegion()
-        : m_pTable(nullptr), m_baseX(0), m_baseY(0), m_currentSolutionIndex(0)
+        : m_pBoard(nullptr), m_baseX(0), m_baseY(0)
     {
 
     }
 
-    void SubRegion::setTable(Table* pTable)
+    void SubRegion::setBoard(Board* pBoard)
     {
-        m_pTable = pTable;
+        m_pBoard = pBoard;
     }
 
     void SubRegion::setBaseCoordinate(int x, int y)
@@ -104,143 +117,178 @@ namespace KSudoku {
         m_cellValueList.push_back(cv);
     }
 
-    bool SubRegion::GetNextPermutation(CellValueList& cellValueList)
-    {
-        CellValueList::iterator it = cellValueList.begin();
-        for (; it != cellValueList.end(); ++it)
-        {
-            bool bIsValueValid = it->takeNextPossibleValue();
-            if (bIsValueValid)
-                return true;
-        }
-
-        return false; // we exhaust all the value combination
-    }
-
-    bool SubRegion::solveByPermutation()
+    // Fills the null cells of the sub-region one by one, depth first. A value already used in the
+    // sub-region is never tried, so a partial assignment is dropped as soon as a digit repeats and
+    // only the valid permutations reach the solution list. The values and masks are built up in
+    // the partial solution, the cells of the board are not touched. Every value placed spends a
+    // node of the budget.
+    //
+    void SubRegion::placeCellValues(size_t k, DigitMask used, const SubRegionSolution& partial, SearchBudget* pBudget)
     {
-        bool bHasSolution = false;
-
-        CellValueList::iterator it = m_cellValueList.begin();
-        for (; it != m_cellValueList.end(); ++it)
+        if (k == m_cellValueList.size())
         {
-            it->takeCurrentPossibleValue();
+            m_solutions.push_back(partial);
+            return;
         }
 
-        if (verify())
-        {
-            bHasSolution = true;
-            addSubRegionSolution();
-        }
+        int n = m_cellValueList[k].cell();
+        int i = Board::rowOf(n) - m_baseX;
+        int j = Board::columnOf(n) - m_baseY;
 
-        while (GetNextPermutation(m_cellValueList))
+        DigitMask candidates = m_cellValueList[k].possibleValues() & ~used;
+        KSUDOKU_COUNT(m_stats.nBranches++);
+        KSUDOKU_COUNT(m_stats.nCandidates += CountDigits(candidates));
+        while (candidates)
         {
-            if (verify())
-            {
-                bHasSolution = true;
-                addSubRegionSolution();
-            }
+            if (pBudget && pBudget->spend())
+                return;
+
+            int v = LowestDigit(candidates);
+            DigitMask bit = DigitToMask(v);
+            candidates &= candidates - 1;
+
+            SubRegionSolution next;
+            next.values = partial.values | ((unsigned long long)v << (4 * k));
+            next.rows = partial.rows | ((PackedMasks)bit << (9 * i));
+            next.columns = partial.columns | ((PackedMasks)bit << (9 * j));
+            KSUDOKU_COUNT(m_stats.nNodes++);
+            placeCellValues(k + 1, used | bit, next, pBudget);
         }
-
-        if (!bHasSolution)
-            printf("we don't find a solution.\n");
-
-        return bHasSolution;
     }
 
-    void SubRegion::addSubRegionSolution()
+    // the solutions can't outnumber the permutations of the null cells nor the candidate combinations
+    size_t SubRegion::maxNumOfSolutions() const
     {
-        SubRegionSolution solution;
-        CellValueList::const_iterator it = m_cellValueList.begin();
-        for (; it != m_cellValueList.end(); ++it)
-            solution.push_back(it->currentValue());
+        size_t nPermutations = 1;
+        size_t nCombinations = 1;
+        for (size_t k = 0; k < m_cellValueList.size(); k++)
+        {
+            nPermutations *= k + 1;
+            nCombinations *= CountDigits(m_cellValueList[k].possibleValues());
+        }
 
-        m_solutions.push_back(solution);
+        return nPermutations < nCombinations ? nPermutations : nCombinations;
     }
 
-    bool SubRegion::verify()
+    bool SubRegion::solveByPermutation(SearchBudget* pBudget)
     {
-        // in this sub region the number 1 ~ 9 should also appear once and only once
-        //
-        int numAppearnce[9];
-        for (int i = 0; i < 9; i++)
-            numAppearnce[i] = 0;
-
+        // the digits of the given cells are taken already
+        DigitMask used = 0;
+        SubRegionSolution partial = { 0, 0, 0 };
         for (int i = 0; i < 3; i++)
         {
             for (int j = 0; j < 3; j++)
             {
-                int cellValue = m_pTable->getCell(m_baseX + i, m_baseY + j).value();
-                numAppearnce[cellValue - 1]++;
+                int n = (m_baseX + i) * 9 + m_baseY + j;
+                if (m_pBoard->isGiven(n))
+                {
+                    DigitMask bit = DigitToMask(m_pBoard->value(n));
+                    used |= bit;
+                    partial.rows |= (PackedMasks)bit << (9 * i);
+                    partial.columns |= (PackedMasks)bit << (9 * j);
+                }
             }
         }
 
-        for (int i = 0; i < 9; i++)
-        {
-            if (numAppearnce[i] != 1)
-                return false;
-        }
+        m_solutions.reserve(maxNumOfSolutions());
+        placeCellValues(0, used, partial, pBudget);
 
-        return true;
+        return !m_solutions.empty() && !(pBudget && pBudget->stopped());
     }
 
-
-    void SubRegion::takeCurrentSolution()
+    // sorts the solutions on their row masks, a group for each distinct masks
+    void SubRegion::indexByRows()
     {
-        SubRegionSolution& sol = m_solutions[m_currentSolutionIndex];
+        std::sort(m_solutions.begin(), m_solutions.end(),
+            [](const SubRegionSolution& a, const SubRegionSolution& b) { return a.rows < b.rows; });
 
-        for (size_t i = 0; i < m_cellValueList.size(); i++)
+        m_rowGroups.clear();
+        for (size_t n = 0; n < m_solutions.size(); n++)
         {
-            m_cellValueList[i].cell()->setValue(sol[i]);
+            if (m_rowGroups.empty() || m_rowGroups.back().key != m_solutions[n].rows)
+                m_rowGroups.push_back({ m_solutions[n].rows, (unsigned)n, 0 });
+            m_rowGroups.back().count++;
         }
     }
 
-    bool SubRegion::takeNextSolution()
+    // empties the null cells again, before the next solution is taken
+    void SubRegion::clearSolution()
     {
-        m_currentSolutionIndex++;
-
-        bool bCurrentIndexValid = false;
-        if (m_currentSolutionIndex < (int)m_solutions.size())
-            bCurrentIndexValid = true;
-        else
+        for (size_t k = 0; k < m_cellValueList.size(); k++)
         {
-            m_currentSolutionIndex = 0;     // reset to 0
-            bCurrentIndexValid = false;
+            int n = m_cellValueList[k].cell();
+            if (m_pBoard->value(n) != 0)
+                m_pBoard->remove(n);
         }
+    }
+
+    void SubRegion::takeSolution(int n)
+    {
+        unsigned long long values = m_solutions[n].values;
 
-        takeCurrentSolution();
-        return bCurrentIndexValid;
+        for (size_t k = 0; k < m_cellValueList.size(); k++)
+        {
+            m_pBoard->place(m_cellValueList[k].cell(), (int)(values >> (4 * k)) & 0xF);
+        }
     }
 
-    typedef std::tuple<int, int, int>           SubRegionRowSolution;
+    // the packed column masks of the three sub-regions of a sub region row solution
+    struct SubRegionRowColumns {
+        PackedMasks columns[3];
+    };
+
+    // A sub region row solution is the index of one solution of each of its sub-regions, stored
+    // with their column masks in one contiguous array. The indexes take 32 bits as a sub-region
+    // without const cells has 9! = 362880 solutions.
+    //
+    struct SubRegionRowSolution {
+        unsigned int        subRegionSolutions[3];
+        SubRegionRowColumns columnMasks;
+    };
     typedef std::vector<SubRegionRowSolution>   SubRegionRowSolutionList;
 
+    // the sub region row solutions reserved up front, more are rarely needed
+    const size_t SUB_REGION_ROW_RESERVE = 1 << 12;
+
     class SubRegionRow
     {
     public:
         SubRegionRow();
-        void setSubRegion(Table* pTable, int nBaseRow, SubRegion* p1, SubRegion* p2, SubRegion* p3);
+        void setSubRegion(Board* pBoard, int nBaseRow, SubRegion* p1, SubRegion* p2, SubRegion* p3);
+
+        template <typename Visit>
+        bool forEachSolution(SearchBudget* pBudget, Visit visit);
+        bool solveByPermutation(SearchBudget* pBudget);
 
-        bool solveByPermutation();
-        bool verify();
+        template <typename Visit>
+        bool forEachFittingSolution(const SubRegionRowColumns& columns, SearchBudget* pBudget, Visit visit);
+        bool findByColumns(const SubRegionRowColumns& columns, unsigned& first, unsigned& count) const;
 
-        void takeCurrentSolution();
-        void setCurrentSolutionIndex(int n) { m_currentSolutionIndex = n; }
-        bool takeNextSolution();
+        void clearSolution();
+        void takeSolution(const SubRegionRowSolution& sol);
+        const SubRegionRowSolution& solution(unsigned n) const  { return m_solutions[n]; }
+        double numOfCombinations() const;
+        unsigned long long numOfSolutions() const           { return m_nSolutions; }
+        size_t numOfListedSolutions() const                 { return m_solutions.size(); }
+        unsigned long long numOfValidations() const         { return m_nValidations; }
 
     private:
-        static bool GetNextPermutation(SubRegion* regions[3]);
-        void addSubRegionRowSolution();
+        void groupByColumns(int level, unsigned first, unsigned end);
+        template <typename Visit>
+        bool visitFittingGroups(int level, unsigned first, unsigned count, const SubRegionRowColumns& columns,
+                                SearchBudget* pBudget, Visit& visit);
     private:
-        Table*                      m_pTable;
+        Board*                      m_pBoard;
         int                         m_baseRow;
         SubRegion*                  m_subRegions[3];
         SubRegionRowSolutionList    m_solutions;
-        int                         m_currentSolutionIndex;
+        KeyGroupList                m_columnGroups[3];  // the solutions by the columns of each sub-region
+        unsigned long long          m_nSolutions;       // the triples joined, listed or not
+        unsigned long long          m_nValidations;     // the keys tried by the joins
     };
 
     SubRegionRow::SubRegionRow()
-        : m_pTable(nullptr), m_baseRow(0), m_currentSolutionIndex(0)
+        : m_pBoard(nullptr), m_baseRow(0), m_nSolutions(0), m_nValidations(0)
     {
         for (int i = 0; i < 3; i++)
         {
@@ -248,64 +296,166 @@ namespace KSudoku {
         }
     }
 
-    void SubRegionRow::setSubRegion(Table* pTable, int nBaseRow, SubRegion* p1, SubRegion* p2, SubRegion* p3)
+    void SubRegionRow::setSubRegion(Board* pBoard, int nBaseRow, SubRegion* p1, SubRegion* p2, SubRegion* p3)
     {
-        m_pTable = pTable;
+        m_pBoard = pBoard;
         m_baseRow = nBaseRow;
         m_subRegions[0] = p1;
         m_subRegions[1] = p2;
         m_subRegions[2] = p3;
     }
 
-    bool SubRegionRow::solveByPermutation()
+    // Joins the solutions of the three sub-regions, indexed by their row masks: each row must get
+    // 9 different digits, so a group of the second sub-region fits one of the first when their
+    // masks share no bit, and then the third sub-region can only have the masks ALL_LINES ^ a ^ b,
+    // looked up exactly. Every solution of the three groups makes a triple, which is passed to
+    // visit as it is found; the join stops when visit returns false.
+    //
+    // A solution never meets one it doesn't fit, only the group keys of the first two sub-regions
+    // are tried against each other. The keys tried and the triples spend the budget, a node each.
+    // Returns false if the join was stopped.
+    //
+    template <typename Visit>
+    bool SubRegionRow::forEachSolution(SearchBudget* pBudget, Visit visit)
     {
-        bool bHasSolution = false;
+        const KeyGroupList& groups0 = m_subRegions[0]->rowGroups();
+        const KeyGroupList& groups1 = m_subRegions[1]->rowGroups();
+        const KeyGroupList& groups2 = m_subRegions[2]->rowGroups();
 
-        for (int i = 0; i < 3; i++)
+        for (size_t g0 = 0; g0 < groups0.size(); g0++)
         {
-            m_subRegions[i]->setCurrentSolutionIndex(0);
-            m_subRegions[i]->takeCurrentSolution();
+            for (size_t g1 = 0; g1 < groups1.size(); g1++)
+            {
+                if (pBudget && pBudget->spend())
+                    return false;
+
+                KSUDOKU_COUNT(m_nValidations++);
+                if (groups0[g0].key & groups1[g1].key)
+                    continue;
+
+                const KeyGroup* pGroup2 = FindGroup(groups2, 0, (unsigned)groups2.size(),
+                                                    ALL_LINES ^ groups0[g0].key ^ groups1[g1].key);
+                if (!pGroup2)
+                    continue;
+
+                const KeyGroup* groups[3] = { &groups0[g0], &groups1[g1], pGroup2 };
+                SubRegionRowSolution sol;
+                for (unsigned n0 = groups[0]->first; n0 < groups[0]->first + groups[0]->count; n0++)
+                {
+                    for (unsigned n1 = groups[1]->first; n1 < groups[1]->first + groups[1]->count; n1++)
+                    {
+                        for (unsigned n2 = groups[2]->first; n2 < groups[2]->first + groups[2]->count; n2++)
+                        {
+                            if (pBudget && pBudget->spend())
+                                return false;
+
+                            sol.subRegionSolutions[0] = n0;
+                            sol.subRegionSolutions[1] = n1;
+                            sol.subRegionSolutions[2] = n2;
+                            for (int i = 0; i < 3; i++)
+                                sol.columnMasks.columns[i] = m_subRegions[i]->columnMasks(sol.subRegionSolutions[i]);
+                            KSUDOKU_COUNT(m_nSolutions++);
+                            if (!visit(sol))
+                                return false;
+                        }
+                    }
+                }
+            }
         }
 
-        if (verify())
+        return true;
+    }
+
+    // Lists every triple, sorted on the column masks of the three sub-regions and indexed by them
+    // for the assembly. False if there are none or the budget ran out.
+    //
+    bool SubRegionRow::solveByPermutation(SearchBudget* pBudget)
+    {
+        SubRegionRowSolutionList& solutions = m_solutions;
+        solutions.reserve(SUB_REGION_ROW_RESERVE);
+        if (!forEachSolution(pBudget, [&solutions](const SubRegionRowSolution& sol) {
+                solutions.push_back(sol);
+                return true;
+            }))
+            return false;
+
+        std::sort(m_solutions.begin(), m_solutions.end(),
+            [](const SubRegionRowSolution& a, const SubRegionRowSolution& b) {
+                for (int i = 0; i < 3; i++)
+                {
+                    if (a.columnMasks.columns[i] != b.columnMasks.columns[i])
+                        return a.columnMasks.columns[i] < b.columnMasks.columns[i];
+                }
+                return false;
+            });
+        groupByColumns(0, 0, (unsigned)m_solutions.size());
+
+        return !m_solutions.empty();
+    }
+
+    // Groups the sorted solutions[first, end) on the columns of sub-region level. A group of the
+    // first two levels points to the groups of the next level within it, one of the last level
+    // to its solutions.
+    //
+    void SubRegionRow::groupByColumns(int level, unsigned first, unsigned end)
+    {
+        KeyGroupList& groups = m_columnGroups[level];
+        size_t nFirstGroup = groups.size();
+        for (unsigned n = first; n < end; n++)
         {
-            bHasSolution = true;
-            addSubRegionRowSolution();
+            PackedMasks key = m_solutions[n].columnMasks.columns[level];
+            if (groups.size() == nFirstGroup || groups.back().key != key)
+                groups.push_back({ key, n, 0 });
+            groups.back().count++;
         }
 
-        while (GetNextPermutation(m_subRegions))
+        if (level == 2)
+            return;
+
+        for (size_t g = nFirstGroup; g < groups.size(); g++)
         {
-            if (verify())
-            {
-                bHasSolution = true;
-                addSubRegionRowSolution();
-            }
+            unsigned nFirst = groups[g].first;
+            unsigned nEnd = nFirst + groups[g].count;
+            groups[g].first = (unsigned)m_columnGroups[level + 1].size();
+            groupByColumns(level + 1, nFirst, nEnd);
+            groups[g].count = (unsigned)m_columnGroups[level + 1].size() - groups[g].first;
         }
+    }
 
-        if (!bHasSolution)
-            printf("we don't find a solution.\n");
-
-        return bHasSolution;
+    // Passes visit the listed solutions whose columns share no digit with columns, going down the
+    // column index: a group which doesn't fit is skipped with all of its solutions. The groups
+    // tried spend the budget, a node each. Returns false if stopped, by visit or the budget.
+    //
+    template <typename Visit>
+    bool SubRegionRow::forEachFittingSolution(const SubRegionRowColumns& columns, SearchBudget* pBudget, Visit visit)
+    {
+        return visitFittingGroups(0, 0, (unsigned)m_columnGroups[0].size(), columns, pBudget, visit);
     }
 
-    bool SubRegionRow::verify()
+    template <typename Visit>
+    bool SubRegionRow::visitFittingGroups(int level, unsigned first, unsigned count, const SubRegionRowColumns& columns,
+                                          SearchBudget* pBudget, Visit& visit)
     {
-        for (int i = 0; i < 3; i++)
+        const KeyGroupList& groups = m_columnGroups[level];
+        for (unsigned g = first; g < first + count; g++)
         {
-            // in each row the number 1 ~ 9 should appear and only appear once
-            int numAppearnce[9];
-            for (int n = 0; n < 9; n++)
-                numAppearnce[n] = 0;
+            if (pBudget && pBudget->spend())
+                return false;
+
+            KSUDOKU_COUNT(m_nValidations++);
+            if (groups[g].key & columns.columns[level])
+                continue;
 
-            for (int j = 0; j < 9; j++)
+            if (level < 2)
             {
-                int cellValue = m_pTable->getCell(m_baseRow + i, j).value();
-                numAppearnce[cellValue - 1]++;
+                if (!visitFittingGroups(level + 1, groups[g].first, groups[g].count, columns, pBudget, visit))
+                    return false;
+                continue;
             }
 
-            for (int n = 0; n < 9; n++)
+            for (unsigned n = groups[g].first; n < groups[g].first + groups[g].count; n++)
             {
-                if (numAppearnce[n] != 1)
+                if (!visit(m_solutions[n]))
                     return false;
             }
         }
@@ -313,85 +463,63 @@ namespace KSudoku {
         return true;
     }
 
-    bool SubRegionRow::GetNextPermutation(SubRegion* regions[3])
+    // the listed solutions[first, first + count) have exactly these columns, false if none has
+    bool SubRegionRow::findByColumns(const SubRegionRowColumns& columns, unsigned& first, unsigned& count) const
     {
-        for (int i = 0; i < 3; i++)
+        unsigned nFirst = 0;
+        unsigned nCount = (unsigned)m_columnGroups[0].size();
+        for (int level = 0; level < 3; level++)
         {
-            bool bIsSolutionValid = regions[i]->takeNextSolution();
-            if (bIsSolutionValid)
-                return true;
+            const KeyGroup* pGroup = FindGroup(m_columnGroups[level], nFirst, nCount, columns.columns[level]);
+            if (!pGroup)
+                return false;
+            nFirst = pGroup->first;
+            nCount = pGroup->count;
         }
 
-        return false;
+        first = nFirst;
+        count = nCount;
+        return true;
     }
 
-    void SubRegionRow::addSubRegionRowSolution()
+    // the triples of sub-region solutions, an upper bound of the solutions
+    double SubRegionRow::numOfCombinations() const
     {
-        SubRegionRowSolution sol(m_subRegions[0]->currentSolutionIndex(),
-            m_subRegions[1]->currentSolutionIndex(),
-            m_subRegions[2]->currentSolutionIndex());
-
-        m_solutions.push_back(sol);
+        return (double)m_subRegions[0]->numOfSolutions() * m_subRegions[1]->numOfSolutions() *
+               m_subRegions[2]->numOfSolutions();
     }
 
-    void SubRegionRow::takeCurrentSolution()
+    void SubRegionRow::clearSolution()
     {
-        SubRegionRowSolution sol = m_solutions[m_currentSolutionIndex];
-        m_subRegions[0]->setCurrentSolutionIndex(std::get<0>(sol));
-        m_subRegions[0]->takeCurrentSolution();
-
-        m_subRegions[1]->setCurrentSolutionIndex(std::get<1>(sol));
-        m_subRegions[1]->takeCurrentSolution();
-
-        m_subRegions[2]->setCurrentSolutionIndex(std::get<2>(sol));
-        m_subRegions[2]->takeCurrentSolution();
+        for (int i = 0; i < 3; i++)
+            m_subRegions[i]->clearSolution();
     }
 
-    bool SubRegionRow::takeNextSolution()
+    void SubRegionRow::takeSolution(const SubRegionRowSolution& sol)
     {
-        m_currentSolutionIndex++;
-
-        bool bCurrentIndexValid = false;
-        if (m_currentSolutionIndex < (int)m_solutions.size())
-            bCurrentIndexValid = true;
-        else
-        {
-            m_currentSolutionIndex = 0;     // reset to 0
-            bCurrentIndexValid = false;
-        }
-
-        takeCurrentSolution();
-        return bCurrentIndexValid;
+        for (int i = 0; i < 3; i++)
+            m_subRegions[i]->takeSolution(sol.subRegionSolutions[i]);
     }
 
-    void BuildCellValueList(Table& table, CellValueList& cellValueList)
+    void BuildCellValueList(Board& board, CellValueList& cellValueList)
     {
         cellValueList.clear();
+        cellValueList.reserve(81);
 
-        for (int i = 0; i < 9; i++)
+        for (int n = 0; n < Board::CELLS; n++)
         {
-            for (int j = 0; j < 9; j++)
-            {
-                Cell* pCell = table.getCellPtr(i, j);
-                if (!pCell->isConst())
-                {
-                    ValueList possibleValueList;
-                    table.getPossibleValues(*pCell, possibleValueList);
-
-                    CellValue valueListEntry(pCell, possibleValueList);
-                    cellValueList.push_back(valueListEntry);
-                }
-            }
+            if (!board.isGiven(n))
+                cellValueList.push_back(CellValue(n, board.candidates(n)));
         }
     }
 
-    void BuildSubRegion(Table* pTable, CellValueList& cellValueList, SubRegion subRegions[3][3])
+    void BuildSubRegion(Board* pBoard, CellValueList& cellValueList, SubRegion subRegions[3][3])
     {
         for (int i = 0; i < 3; i++)
         {
             for (int j = 0; j < 3; j++)
             {
-                subRegions[i][j].setTable(pTable);
+                subRegions[i][j].setBoard(pBoard);
                 subRegions[i][j].setBaseCoordinate(i * 3, j * 3);
             }
         }
@@ -399,98 +527,180 @@ namespace KSudoku {
         CellValueList::iterator it = cellValueList.begin();
         for (; it != cellValueList.end(); ++it)
         {
-            int i = it->cell()->x() / 3;
-            int j = it->cell()->y() / 3;
+            int i = Board::rowOf(it->cell()) / 3;
+            int j = Board::columnOf(it->cell()) / 3;
             subRegions[i][j].addCellValue(*it);
         }
     }
 
-    bool GetNextPermutation(SubRegionRow subRegionRows[3])
+    int JoinSubRegions(Board& board, SubRegion subRegions[3][3], SubRegionRow subRegionRows[3], bool bFindAll,
+                       bool bPrint, SearchBudget* pBudget, SearchStats* pStats, unsigned long long& nValidations);
+
+    // Algorithm:
+    //
+    // 1. Find all the valid permutations of the null cells in each sub-region, and index them by
+    //    their row masks.
+    // 2. Join the sub-region solutions of the two sub region rows with the fewest combinations,
+    //    keeping the triples whose rows fit, and index those by their column masks.
+    // 3. Join the triples of the last sub region row one at a time, as they are found, with the
+    //    fitting solutions of the second row, and look up the third row solutions with exactly
+    //    the columns the two leave out. Every one found is a solution of the whole board.
+    //
+    // The board is left filled with the last solution found. With bFindAll false the join stops
+    // at the first solution, before the last sub region row is joined any further. Returns the
+    // number of solutions, printed if bPrint is set.
+    //
+    // The nodes added to pStats are the values placed in the sub-regions, the validations are
+    // the keys tried by the joins. Both spend the budget, as do the triples and solutions found,
+    // and when it runs out the solutions found so far are all there is.
+    //
+    int PermutationJoin(Board& board, bool bFindAll, bool bPrint, SearchBudget* pBudget, SearchStats* pStats)
     {
-        for (int i = 0; i < 3; i++)
+        SubRegion subRegions[3][3];
         {
-            bool bHasSolution = subRegionRows[i].takeNextSolution();
-            if (bHasSolution)
-                return true;
+            PhaseTimer timer(pStats, PHASE_PREPARE);
+            CellValueList cellValueList;
+            BuildCellValueList(board, cellValueList);
+            BuildSubRegion(&board, cellValueList, subRegions);
         }
 
-        return false;
-    }
-
-
-    bool SolveByPermutation(Table& table)
-    {
-        bool bHasSolution = false;
-
-        CellValueList cellValueList;
-        BuildCellValueList(table, cellValueList);
-
-        SubRegion subRegions[3][3];
-        BuildSubRegion(&table, cellValueList, subRegions);
+        SubRegionRow subRegionRows[3];
+        unsigned long long nValidations = 0;
+        int nSolutions = JoinSubRegions(board, subRegions, subRegionRows, bFindAll, bPrint, pBudget, pStats, nValidations);
 
-        // firstly find solutions for each sub-region
-        for (int i = 0; i < 3; i++)
+#if KSUDOKU_STATS
+        if (pStats)
         {
-            for (int j = 0; j < 3; j++)
+            SearchStats stats;
+            stats.nValidations = nValidations;
+            for (int i = 0; i < 3; i++)
             {
-                bHasSolution = subRegions[i][j].solveByPermutation();
-                if (!bHasSolution)
+                for (int j = 0; j < 3; j++)
                 {
-                    printf("we don't find a solution.\n");
-                    return false;
+                    stats.add(subRegions[i][j].stats());
+                    stats.nBoxSolutions += subRegions[i][j].numOfSolutions();
+                    if ((unsigned long long)subRegions[i][j].numOfSolutions() > stats.nPeakSolutions)
+                        stats.nPeakSolutions = subRegions[i][j].numOfSolutions();
                 }
+
+                stats.nValidations += subRegionRows[i].numOfValidations();
+                stats.nBandSolutions += subRegionRows[i].numOfSolutions();
+                if ((unsigned long long)subRegionRows[i].numOfListedSolutions() > stats.nPeakSolutions)
+                    stats.nPeakSolutions = subRegionRows[i].numOfListedSolutions();
             }
+            pStats->add(stats);
         }
+#endif
 
-        // divide the sub regions into 3 sub region rows
-        bHasSolution = false;
+        return nSolutions;
+    }
 
-        SubRegionRow subRegionRows[3];
-        subRegionRows[0].setSubRegion(&table, 0, &subRegions[0][0], &subRegions[0][1], &subRegions[0][2]);
-        subRegionRows[1].setSubRegion(&table, 3, &subRegions[1][0], &subRegions[1][1], &subRegions[1][2]);
-        subRegionRows[2].setSubRegion(&table, 6, &subRegions[2][0], &subRegions[2][1], &subRegions[2][2]);
+    int JoinSubRegions(Board& board, SubRegion subRegions[3][3], SubRegionRow subRegionRows[3], bool bFindAll,
+                       bool bPrint, SearchBudget* pBudget, SearchStats* pStats, unsigned long long& nValidations)
+    {
+#if !KSUDOKU_STATS
+        (void)nValidations;     // only counted with the stats
+#endif
 
-        for (int i = 0; i < 3; i++)
+        // firstly find solutions for each sub-region
         {
-            bHasSolution = subRegionRows[i].solveByPermutation();
-            if (!bHasSolution)
+            PhaseTimer timer(pStats, PHASE_BOX_ENUMERATION);
+            for (int i = 0; i < 3; i++)
             {
-                printf("we don't find a solution.\n");
-                return false;
+                for (int j = 0; j < 3; j++)
+                {
+                    if (!subRegions[i][j].solveByPermutation(pBudget))
+                        return 0;
+                    subRegions[i][j].indexByRows();
+                }
             }
         }
 
-        // now let all sub region rows take their first solution, verify
-        bHasSolution = false;
+        // divide the sub regions into 3 sub region rows, the one with the most combinations is
+        // joined last, as the assembly goes, and never listed
+        subRegionRows[0].setSubRegion(&board, 0, &subRegions[0][0], &subRegions[0][1], &subRegions[0][2]);
+        subRegionRows[1].setSubRegion(&board, 3, &subRegions[1][0], &subRegions[1][1], &subRegions[1][2]);
+        subRegionRows[2].setSubRegion(&board, 6, &subRegions[2][0], &subRegions[2][1], &subRegions[2][2]);
 
-        for (int i = 0; i < 3; i++)
+        int nLast = 0;
+        for (int i = 1; i < 3; i++)
         {
-            subRegionRows[i].setCurrentSolutionIndex(0);
-            subRegionRows[i].takeCurrentSolution();
+            if (subRegionRows[i].numOfCombinations() > subRegionRows[nLast].numOfCombinations())
+                nLast = i;
         }
+        SubRegionRow& b0 = subRegionRows[nLast];
+        SubRegionRow& b1 = subRegionRows[(nLast + 1) % 3];
+        SubRegionRow& b2 = subRegionRows[(nLast + 2) % 3];
 
-        if (table.veifyAll())
         {
-            bHasSolution = true;
-            printf("we find a solution.\n");
-            table.print();
+            PhaseTimer timer(pStats, PHASE_BAND_JOIN);
+            if (!b1.solveByPermutation(pBudget) || !b2.solveByPermutation(pBudget))
+                return 0;
         }
 
-        // now permutate the solutions in each sub region row to get the solution of the whole table
-        while (GetNextPermutation(subRegionRows))
-        {
-            if (table.veifyAll())
-            {
-                bHasSolution = true;
-                printf("we find a solution.\n");
-                table.print();
-            }
-        }
+        PhaseTimer timer(pStats, PHASE_ASSEMBLY);
+
+        // now join the sub region rows on their columns to get the solutions of the whole board
+        int nSolutions = 0;
+        b0.forEachSolution(pBudget, [&](const SubRegionRowSolution& sol0) {
+            return b1.forEachFittingSolution(sol0.columnMasks, pBudget, [&](const SubRegionRowSolution& sol1) {
+                if (pBudget && pBudget->spend())
+                    return false;
 
-        if (!bHasSolution)
+                SubRegionRowColumns columns2;
+                for (int k = 0; k < 3; k++)
+                    columns2.columns[k] = ALL_LINES ^ sol0.columnMasks.columns[k] ^ sol1.columnMasks.columns[k];
+
+                KSUDOKU_COUNT(nValidations++);
+                unsigned first = 0;
+                unsigned count = 0;
+                if (!b2.findByColumns(columns2, first, count))
+                    return true;
+
+                for (unsigned n2 = first; n2 < first + count; n2++)
+                {
+                    if (pBudget && pBudget->spend())
+                        return false;
+
+                    // every band is cleared first, the digits of the last solution would clash
+                    // with the masks of the new one
+                    b0.clearSolution();
+                    b1.clearSolution();
+                    b2.clearSolution();
+                    b0.takeSolution(sol0);
+                    b1.takeSolution(sol1);
+                    b2.takeSolution(b2.solution(n2));
+                    nSolutions++;
+
+                    if (bPrint)
+                    {
+                        printf("we find a solution.\n");
+                        PrintBoard(board);
+                    }
+                    if (!bFindAll)
+                        return false;
+                }
+                return true;
+            });
+        });
+
+        return nSolutions;
+    }
+
+    bool SolveByPermutation(Board& board, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        bool bHasSolution = PermutationJoin(board, true, true, pBudget, pStats) > 0;
+        if (pBudget && pBudget->stopped())
+            printf("we give up: %s\n", SearchStopName(pBudget->reason()));
+        else if (!bHasSolution)
             printf("we don't find a solution.\n");
 
         return bHasSolution;
     }
 
-}
\ No newline at end of file
+    bool SearchPermutation(Board& board, SearchBudget* pBudget, SearchStats* pStats)
+    {
+        return PermutationJoin(board, false, false, pBudget, pStats) > 0;
+    }
+
+}
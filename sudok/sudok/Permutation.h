@@ -1,7 +1,15 @@
 #pragma once
 
 namespace KSudoku {
-    class Table;
+    template <int BoxSize> class BasicBoard;
+    typedef BasicBoard<3> Board;
+    struct SearchStats;
+    class SearchBudget;
 
-    bool SolveByPermutation(Table& table);
+    // prints every solution of the board, until the budget runs out
+    bool SolveByPermutation(Board& board, SearchBudget* pBudget, SearchStats* pStats);
+
+    // fills the board with the first solution found, without printing, false if there is none
+    // or the budget ran out, pBudget and pStats may be NULL
+    bool SearchPermutation(Board& board, SearchBudget* pBudget, SearchStats* pStats);
 }
\ No newline at end of file
@@ -0,0 +1,328 @@
+#include "stdafx.h"
+#include "Portfolio.h"
+#include "Board.h"
+#include "Canonical.h"
+#include "Propagation.h"
+#include "BackTracking.h"
+#include "BitMask.h"
+#include "MRV.h"
+#include "DLX.h"
+#include "Permutation.h"
+#include "SearchStats.h"
+#include "PuzzleFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+namespace KSudoku {
+
+    struct PortfolioEngine {
+        const char*     name;
+        bool            (*search)(Board& board, SearchBudget* pBudget, SearchStats* pStats);
+    };
+
+    const PortfolioEngine PORTFOLIO_ENGINES[] = {
+        { "backtracking",   SearchBackTracking },
+        { "bitmask",        SearchBitMask },
+        { "mrv",            SearchMRV },
+        { "dlx",            SearchDLX },
+        { "permutation",    SearchPermutation },
+    };
+    const int PORTFOLIO_ENGINE_COUNT = sizeof(PORTFOLIO_ENGINES) / sizeof(PORTFOLIO_ENGINES[0]);
+
+    bool ParsePortfolioConfigs(const char* list, std::vector<PortfolioConfig>& configs)
+    {
+        configs.clear();
+        const char* p = list;
+        while (*p)
+        {
+            const char* end = p + strcspn(p, ",");
+            const char* colon = (const char*)memchr(p, ':', end - p);
+            size_t nName = (colon ? colon : end) - p;
+
+            PortfolioConfig config;
+            config.nEngine = -1;
+            config.seed = 0;
+            for (int k = 0; k < PORTFOLIO_ENGINE_COUNT; k++)
+            {
+                if (strlen(PORTFOLIO_ENGINES[k].name) == nName && strncmp(p, PORTFOLIO_ENGINES[k].name, nName) == 0)
+                    config.nEngine = k;
+            }
+            if (config.nEngine < 0)
+                return false;
+
+            if (colon)
+            {
+                char* pSeedEnd;
+                config.seed = (unsigned int)strtoul(colon + 1, &pSeedEnd, 10);
+                if (colon + 1 == end || pSeedEnd != end)
+                    return false;
+            }
+
+            configs.push_back(config);
+            p = *end ? end + 1 : end;
+        }
+
+        return !configs.empty();
+    }
+
+    // the symmetry of a seed: the bands and the rows within each band shuffled, the same for the
+    // columns, maybe a transposition and the digits relabeled
+    void RandomTransform(unsigned int seed, GridTransform& transform)
+    {
+        std::mt19937 random(seed);
+        transform.bTranspose = (random() & 1) != 0;
+
+        unsigned char* lines[2] = { transform.rows, transform.columns };
+        for (int k = 0; k < 2; k++)
+        {
+            unsigned char bands[3] = { 0, 1, 2 };
+            std::shuffle(bands, bands + 3, random);
+            for (int b = 0; b < 3; b++)
+            {
+                unsigned char inner[3] = { 0, 1, 2 };
+                std::shuffle(inner, inner + 3, random);
+                for (int i = 0; i < 3; i++)
+                    lines[k][b * 3 + i] = (unsigned char)(bands[b] * 3 + inner[i]);
+            }
+        }
+
+        for (int v = 0; v <= 9; v++)
+            transform.digits[v] = (unsigned char)v;
+        std::shuffle(transform.digits + 1, transform.digits + 10, random);
+    }
+
+    // One puzzle raced by all the configurations. The first one to finish, with a solution or
+    // with the proof there is none, takes the win and stops the others through the budget.
+    //
+    struct PortfolioRace {
+        PortfolioRace(int nConfigs) : stop(STOP_NONE), nWinner(-1), status(SOLVE_NO_SOLUTION), stats(nConfigs) {}
+
+        Board                       board;          // the puzzle with its singles filled
+        SearchLimits                limits;
+        std::atomic<SearchStop>     stop;           // set by the winner, or the first to give up at the deadline
+        std::atomic<int>            nWinner;
+        SolveStatus                 status;         // written only by the winner
+        char                        solution[81];   // the same
+        std::vector<SearchStats>    stats;          // one per configuration
+        TaskGroup                   group;
+    };
+
+    void RunConfig(const PortfolioConfig& config, PortfolioRace& race, int k)
+    {
+        Board board = race.board;
+        GridTransform transform;
+        if (config.seed != 0)
+        {
+            char cells[81];
+            char transformed[81];
+            RandomTransform(config.seed, transform);
+            StoreBoard(race.board, cells);
+            TransformGrid(transform, cells, transformed);
+            LoadBoard(board, transformed);
+        }
+
+        // the node limit is each one's own, only the winner and the deadline stop the others
+        SearchBudget budget(race.limits, nullptr, &race.stop);
+        bool bSolved = PORTFOLIO_ENGINES[config.nEngine].search(board, &budget, &race.stats[k]);
+        if (budget.stopped())
+            return;
+
+        int nNone = -1;
+        if (!race.nWinner.compare_exchange_strong(nNone, k))
+            return;
+
+        bSolved = bSolved && VerifySolution(board);
+        race.status = bSolved ? SOLVE_SOLVED : SOLVE_NO_SOLUTION;
+        if (bSolved)
+        {
+            char cells[81];
+            StoreBoard(board, cells);
+            if (config.seed != 0)
+                UntransformGrid(transform, cells, race.solution);
+            else
+                memcpy(race.solution, cells, sizeof(cells));
+        }
+
+        SearchStop none = STOP_NONE;
+        race.stop.compare_exchange_strong(none, STOP_CANCELLED);
+    }
+
+    PortfolioSolver::PortfolioSolver(const std::vector<PortfolioConfig>& configs)
+        : m_configs(configs), m_wins(configs.size()), m_pool((int)configs.size())
+    {
+    }
+
+    std::string PortfolioSolver::configName(int k) const
+    {
+        std::string name = PORTFOLIO_ENGINES[m_configs[k].nEngine].name;
+        if (m_configs[k].seed != 0)
+        {
+            char seed[16];
+            snprintf(seed, sizeof(seed), ":%u", m_configs[k].seed);
+            name += seed;
+        }
+        return name;
+    }
+
+    SolveStatus PortfolioSolver::solve(const char puzzle[81], char solution[81], const SearchLimits& limits, int* pWinner,
+                                       SearchStats* pStats)
+    {
+        if (pWinner)
+            *pWinner = -1;
+        if (!puzzle || !solution)
+            return SOLVE_INVALID_ARGUMENT;
+
+        // the singles are the same for every configuration, they are filled once
+        PortfolioRace race((int)m_configs.size());
+        {
+            PhaseTimer timer(pStats, PHASE_PREPARE);
+            if (!LoadBoard(race.board, puzzle))
+                return SOLVE_INVALID_PUZZLE;
+            if (!Propagate(race.board))
+                return SOLVE_NO_SOLUTION;
+        }
+
+        bool bFull = true;
+        for (int n = 0; n < Board::CELLS && bFull; n++)
+            bFull = race.board.value(n) != 0;
+        if (bFull)
+        {
+            if (!VerifySolution(race.board))
+                return SOLVE_NO_SOLUTION;
+            StoreBoard(race.board, solution);
+            return SOLVE_SOLVED;
+        }
+
+        race.limits = limits;
+        PortfolioRace* pRace = &race;
+        for (int k = 0; k < (int)m_configs.size(); k++)
+        {
+            const PortfolioConfig* pConfig = &m_configs[k];
+            m_pool.submit(race.group, [pConfig, pRace, k](int) {
+                RunConfig(*pConfig, *pRace, k);
+            });
+        }
+        race.group.wait();
+
+        if (pStats)
+        {
+            for (size_t k = 0; k < race.stats.size(); k++)
+                pStats->add(race.stats[k]);
+        }
+
+        int nWinner = race.nWinner.load();
+        if (nWinner < 0)
+        {
+            // every configuration gave up, at the deadline, on being cancelled or each at its node limit
+            SearchStop reason = race.stop.load();
+            return StoppedStatus(reason == STOP_NONE ? STOP_NODE_LIMIT : reason);
+        }
+
+        m_wins[nWinner]++;
+        if (pWinner)
+            *pWinner = nWinner;
+        if (race.status == SOLVE_SOLVED)
+            memcpy(solution, race.solution, 81);
+        return race.status;
+    }
+
+    int SolvePortfolioFile(const char* inputFileName, const char* outputFileName, const PortfolioOptions& options,
+                           SearchStats* pStats)
+    {
+        MappedFile file;
+        if (!file.open(inputFileName))
+        {
+            fprintf(stderr, "can't open %s\n", inputFileName);
+            return -1;
+        }
+
+        FILE* output = stdout;
+        if (outputFileName)
+        {
+            output = fopen(outputFileName, "w");
+            if (!output)
+            {
+                fprintf(stderr, "can't open %s\n", outputFileName);
+                return -1;
+            }
+        }
+        setvbuf(output, NULL, _IOFBF, 1 << 16);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        PortfolioSolver solver(options.configs);
+        PuzzleParser parser(file.begin(), file.end());
+        long long nPuzzles = 0;
+        long long nBySingles = 0;
+        int nFailed = 0;
+        char puzzle[81];
+        char solution[81];
+        for (;;)
+        {
+            ParseResult result;
+            {
+                PhaseTimer timer(pStats, PHASE_PARSE);
+                result = parser.next(puzzle);
+            }
+            if (result == PARSE_END)
+                break;
+
+            nPuzzles++;
+            if (result == PARSE_MALFORMED)
+            {
+                fprintf(stderr, "%s line %lld, offset %lld: invalid puzzle, %s\n", inputFileName,
+                    parser.recordLine(), parser.recordOffset(), parser.error());
+                fputs("invalid\n", output);
+                nFailed++;
+                continue;
+            }
+
+            // every puzzle has the whole time to itself
+            SearchLimits limits = options.nTimeoutMs > 0 ? SearchLimitsIn(options.nTimeoutMs) : NoSearchLimits();
+            limits.nMaxNodes = options.nMaxNodes;
+            int nWinner;
+            SolveStatus status = solver.solve(puzzle, solution, limits, &nWinner, pStats);
+            if (status == SOLVE_SOLVED)
+            {
+                char line[82];
+                for (int i = 0; i < 81; i++)
+                    line[i] = (char)('0' + solution[i]);
+                line[81] = '\n';
+                fwrite(line, 1, sizeof(line), output);
+                if (nWinner < 0)
+                    nBySingles++;
+            }
+            else if (status == SOLVE_INVALID_PUZZLE)
+            {
+                fprintf(stderr, "%s line %lld, offset %lld: invalid puzzle, a digit given twice in a row, column or sub-region\n",
+                    inputFileName, parser.recordLine(), parser.recordOffset());
+                fputs("invalid\n", output);
+                nFailed++;
+            }
+            else
+            {
+                fprintf(output, "%s\n", SolveStatusName(status));
+                nFailed++;
+            }
+        }
+
+        if (output != stdout)
+            fclose(output);
+        else
+            fflush(output);
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "%lld puzzles, %lld solved in %.3f s with %d configurations, %.0f puzzles/second\n",
+            nPuzzles, nPuzzles - nFailed, seconds, solver.numConfigs(), seconds > 0 ? nPuzzles / seconds : 0.0);
+        fprintf(stderr, "%-20s %10lld wins\n", "singles", nBySingles);
+        for (int k = 0; k < solver.numConfigs(); k++)
+            fprintf(stderr, "%-20s %10llu wins\n", solver.configName(k).c_str(), solver.wins(k));
+
+        return nFailed;
+    }
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Solver.h"
+#include "ThreadPool.h"
+
+namespace KSudoku {
+
+    // One way to solve a puzzle in a portfolio: an engine, backtracking, bitmask, mrv, dlx or
+    // permutation, run on the puzzle as it is (seed 0) or on a random symmetry of it picked by
+    // the seed, the cells and digits shuffled so the engine walks the search tree in another
+    // order. Written "engine" or "engine:seed".
+    struct PortfolioConfig {
+        int             nEngine;
+        unsigned int    seed;
+    };
+
+    // Reads a comma separated list of configurations, false if one of them is unknown.
+    bool ParsePortfolioConfigs(const char* list, std::vector<PortfolioConfig>& configs);
+
+    // the configurations raced when none are given
+    const char* const DEFAULT_PORTFOLIO = "mrv,dlx,mrv:1,bitmask:2";
+
+    // Races several configurations on each puzzle, one worker thread each, takes the answer of
+    // the first one to finish and cancels the others. The workers live as long as the solver,
+    // so a puzzle costs a few tasks, not a few threads. It counts how many races each
+    // configuration won, to tune the mix. One puzzle is solved at a time.
+    //
+    class PortfolioSolver {
+    public:
+        explicit PortfolioSolver(const std::vector<PortfolioConfig>& configs);
+
+        // Solves the puzzle like SolveGrid, the limits hold for every configuration on its own.
+        // *pWinner is the configuration which answered, -1 if the singles solved the puzzle or
+        // none answered, pWinner may be NULL. The stats of all the configurations are added to
+        // pStats unless it is NULL.
+        SolveStatus solve(const char puzzle[81], char solution[81], const SearchLimits& limits, int* pWinner,
+                          SearchStats* pStats);
+
+        int                 numConfigs() const      { return (int)m_configs.size(); }
+        std::string         configName(int k) const;
+        unsigned long long  wins(int k) const       { return m_wins[k]; }
+
+    private:
+        PortfolioSolver(const PortfolioSolver&);
+        PortfolioSolver& operator=(const PortfolioSolver&);
+
+    private:
+        std::vector<PortfolioConfig>    m_configs;
+        std::vector<unsigned long long> m_wins;
+        WorkStealingPool                m_pool;
+    };
+
+    struct PortfolioOptions {
+        std::vector<PortfolioConfig>    configs;
+        long long                       nTimeoutMs;     // the time a puzzle may take, 0 for no limit
+        unsigned long long              nMaxNodes;      // the nodes of each configuration on a puzzle, 0 for no limit
+    };
+
+    // Solves the puzzles of a file one after the other with a portfolio and writes one line per
+    // puzzle to the output file (stdout if NULL), as the batch mode does, then the wins of each
+    // configuration. Returns the number of puzzles not solved, -1 if a file can't be opened.
+    int SolvePortfolioFile(const char* inputFileName, const char* outputFileName, const PortfolioOptions& options,
+                           SearchStats* pStats);
+}
@@ -0,0 +1,13 @@
+#include "stdafx.h"
+#include "Board.h"
+#include "BasicPropagation.h"
+#include "Propagation.h"
+
+namespace KSudoku {
+
+    bool Propagate(Board& board)
+    {
+        return PropagateBoard<3>(board);
+    }
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace KSudoku {
+    template <int BoxSize> class BasicBoard;
+    typedef BasicBoard<3> Board;
+
+    // Fills every cell forced by naked or hidden singles as a given cell, until there is none left.
+    // Returns false if the board is found to have a contradiction, which means no solution.
+    bool Propagate(Board& board);
+}
@@ -0,0 +1,262 @@
+#include "stdafx.h"
+#include "PuzzleFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace KSudoku {
+
+    MappedFile::MappedFile()
+        : m_pData(nullptr), m_nSize(0)
+#ifdef _WIN32
+        , m_hFile(INVALID_HANDLE_VALUE), m_hMapping(nullptr)
+#endif
+    {
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::open(const char* fileName)
+    {
+        close();
+
+        m_hFile = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_hFile, &size))
+        {
+            close();
+            return false;
+        }
+        if (size.QuadPart == 0)
+            return true;        // an empty file can't be mapped, but it is a valid one
+
+        m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_hMapping)
+        {
+            close();
+            return false;
+        }
+
+        m_pData = (const char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+        if (!m_pData)
+        {
+            close();
+            return false;
+        }
+        m_nSize = (size_t)size.QuadPart;
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_pData)
+            UnmapViewOfFile(m_pData);
+        if (m_hMapping)
+            CloseHandle(m_hMapping);
+        if (m_hFile != INVALID_HANDLE_VALUE)
+            CloseHandle(m_hFile);
+
+        m_pData = nullptr;
+        m_nSize = 0;
+        m_hMapping = nullptr;
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+
+#else
+
+    bool MappedFile::open(const char* fileName)
+    {
+        close();
+
+        int fd = ::open(fileName, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        if (st.st_size == 0)
+        {
+            ::close(fd);
+            return true;        // an empty file can't be mapped, but it is a valid one
+        }
+
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);            // the mapping keeps the file open
+        if (p == MAP_FAILED)
+            return false;
+
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+        m_pData = (const char*)p;
+        m_nSize = (size_t)st.st_size;
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_pData)
+            munmap((void*)m_pData, m_nSize);
+
+        m_pData = nullptr;
+        m_nSize = 0;
+    }
+
+#endif
+
+    PuzzleParser::PuzzleParser(const char* begin, const char* end)
+        : m_pBegin(begin), m_pEnd(end), m_p(begin), m_nLine(0),
+          m_nRecordOffset(0), m_nRecordLine(0), m_pError(nullptr)
+    {
+    }
+
+    // Reads one line, writing its first nMaxCells cells and counting all of them, and leaves
+    // m_p at the start of the next line.
+    PuzzleParser::LineKind PuzzleParser::scanLine(char* cells, int nMaxCells, int& nCells)
+    {
+        const char* p = m_p;
+        const char* end = m_pEnd;
+        bool bBad = false;
+        bool bComment = false;
+        int n = 0;
+
+        for (; p != end && *p != '\n'; ++p)
+        {
+            char c = *p;
+            if (bComment || c == ' ' || c == '\t' || c == '\r')
+                continue;
+
+            if ((unsigned char)(c - '0') <= 9)
+            {
+                if (n < nMaxCells)
+                    cells[n] = (char)(c - '0');
+                n++;
+            }
+            else if (c == '.')
+            {
+                if (n < nMaxCells)
+                    cells[n] = 0;
+                n++;
+            }
+            else if (c == '#' && n == 0 && !bBad)
+                bComment = true;
+            else
+                bBad = true;
+        }
+
+        m_p = p == end ? end : p + 1;
+        m_nLine++;
+        nCells = n;
+
+        if (bBad)
+            return LINE_BAD;
+        return n == 0 ? LINE_BLANK : LINE_CELLS;
+    }
+
+    // Skips up to nRows lines, stopping after a blank line or before a puzzle line.
+    void PuzzleParser::skipRows(int nRows)
+    {
+        for (int i = 0; i < nRows && m_p != m_pEnd; i++)
+        {
+            const char* line = m_p;
+            int nCells = 0;
+            LineKind kind = scanLine(nullptr, 0, nCells);
+            if (kind == LINE_BLANK)
+                return;
+            if (kind == LINE_CELLS && nCells == 81)
+            {
+                m_p = line;
+                m_nLine--;
+                return;
+            }
+        }
+    }
+
+    ParseResult PuzzleParser::next(char cells[81])
+    {
+        for (;;)
+        {
+            if (m_p == m_pEnd)
+                return PARSE_END;
+
+            m_nRecordOffset = m_p - m_pBegin;
+            m_nRecordLine = m_nLine + 1;
+
+            int nCells = 0;
+            LineKind kind = scanLine(cells, 81, nCells);
+            if (kind == LINE_BLANK)
+                continue;
+
+            if (kind == LINE_BAD)
+            {
+                m_pError = "a character which is neither a digit nor \".\"";
+                return PARSE_MALFORMED;
+            }
+            if (nCells == 81)
+                return PARSE_PUZZLE;
+            if (nCells != 9)
+            {
+                m_pError = "a line with neither 81 nor 9 cells";
+                return PARSE_MALFORMED;
+            }
+
+            // the first row of a grid, the next 8 lines must be its other rows
+            for (int i = 1; i < 9; i++)
+            {
+                if (m_p == m_pEnd)
+                {
+                    m_nRecordOffset = m_p - m_pBegin;
+                    m_nRecordLine = m_nLine + 1;
+                    m_pError = "the grid ends before its 9th row";
+                    return PARSE_MALFORMED;
+                }
+
+                const char* row = m_p;
+                kind = scanLine(cells + i * 9, 9, nCells);
+                if (kind != LINE_CELLS || nCells != 9)
+                {
+                    // point at the row which went wrong rather than at the start of the grid
+                    m_nRecordOffset = row - m_pBegin;
+                    m_nRecordLine = m_nLine;
+                    m_pError = kind == LINE_BLANK ? "the grid ends before its 9th row"
+                             : kind == LINE_BAD ? "a character which is neither a digit nor \".\""
+                             : "a row of the grid without 9 cells";
+
+                    // a puzzle line is the next record, the grid ended before it; otherwise the
+                    // rows left of the grid mustn't be taken for the start of another one
+                    if (kind == LINE_CELLS && nCells == 81)
+                    {
+                        m_p = row;
+                        m_nLine--;
+                        m_pError = "the grid ends before its 9th row";
+                    }
+                    else if (kind != LINE_BLANK)
+                        skipRows(8 - i);
+                    return PARSE_MALFORMED;
+                }
+            }
+
+            return PARSE_PUZZLE;
+        }
+    }
+
+}
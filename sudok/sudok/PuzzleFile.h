@@ -0,0 +1,75 @@
+#pragma once
+#include <stddef.h>
+
+namespace KSudoku {
+
+    // A whole file mapped read-only into memory, the puzzles are parsed straight from its bytes.
+    class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        bool        open(const char* fileName);     // false if the file can't be opened or mapped
+        void        close();
+
+        const char* begin() const   { return m_pData; }
+        const char* end() const     { return m_pData + m_nSize; }
+        size_t      size() const    { return m_nSize; }
+
+    private:
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+    private:
+        const char* m_pData;
+        size_t      m_nSize;
+#ifdef _WIN32
+        void*       m_hFile;
+        void*       m_hMapping;
+#endif
+    };
+
+    enum ParseResult {
+        PARSE_PUZZLE,       // a puzzle was parsed
+        PARSE_MALFORMED,    // a record which isn't a puzzle, see recordOffset() and error()
+        PARSE_END           // no record left
+    };
+
+    // Reads the puzzles of a buffer one record at a time, in either of the two formats:
+    //
+    //   one puzzle per line, 81 cells row by row:  3...679..1...8925..65.4.3....2....3.8.6..
+    //   nine lines of nine cells:                  3 0 0 0 6 7 9 0 0
+    //                                              1 0 0 0 8 9 2 5 0 ...
+    //
+    // A cell is a digit, "0" or "." for a null cell, and spaces or tabs may separate the cells.
+    // Blank lines and lines starting with "#" are skipped. A malformed record is reported with
+    // the byte offset and line where it went wrong, and parsing goes on after that line, or after
+    // the rest of the grid when a grid row goes wrong.
+    //
+    class PuzzleParser {
+    public:
+        PuzzleParser(const char* begin, const char* end);
+
+        ParseResult next(char cells[81]);               // the cells 0 ~ 9 row by row
+
+        // where the last record starts, or where it went wrong if it is malformed
+        long long   recordOffset() const    { return m_nRecordOffset; }
+        long long   recordLine() const      { return m_nRecordLine; }      // from 1
+        const char* error() const           { return m_pError; }
+
+    private:
+        enum LineKind { LINE_BLANK, LINE_CELLS, LINE_BAD };
+        LineKind    scanLine(char* cells, int nMaxCells, int& nCells);
+        void        skipRows(int nRows);
+
+    private:
+        const char* m_pBegin;
+        const char* m_pEnd;
+        const char* m_p;
+        long long   m_nLine;
+        long long   m_nRecordOffset;
+        long long   m_nRecordLine;
+        const char* m_pError;
+    };
+
+}
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "SearchBudget.h"
+
+namespace KSudoku {
+
+    SearchLimits NoSearchLimits()
+    {
+        SearchLimits limits;
+        limits.deadline = std::chrono::steady_clock::time_point::max();
+        limits.nMaxNodes = 0;
+        limits.pCancel = nullptr;
+        return limits;
+    }
+
+    SearchLimits SearchLimitsIn(long long nMilliseconds)
+    {
+        SearchLimits limits = NoSearchLimits();
+        limits.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(nMilliseconds);
+        return limits;
+    }
+
+    const char* SearchStopName(SearchStop reason)
+    {
+        switch (reason)
+        {
+        case STOP_NONE:         return "not stopped";
+        case STOP_DEADLINE:     return "timed out";
+        case STOP_NODE_LIMIT:   return "node limit reached";
+        case STOP_CANCELLED:    return "cancelled";
+        }
+        return "unknown";
+    }
+
+    SearchBudget::SearchBudget(const SearchLimits& limits)
+        : m_limits(limits), m_pSharedNodes(nullptr), m_pSharedStop(nullptr), m_nNodes(0), m_stop(STOP_NONE)
+    {
+        startInterval(0);
+    }
+
+    SearchBudget::SearchBudget(const SearchLimits& limits, std::atomic<unsigned long long>* pSharedNodes,
+                               std::atomic<SearchStop>* pSharedStop)
+        : m_limits(limits), m_pSharedNodes(pSharedNodes), m_pSharedStop(pSharedStop), m_nNodes(0), m_stop(STOP_NONE)
+    {
+        startInterval(pSharedNodes ? pSharedNodes->load(std::memory_order_relaxed) : 0);
+    }
+
+    // the next look comes after SEARCH_CHECK_INTERVAL nodes, or on the first node past the limit
+    void SearchBudget::startInterval(unsigned long long nTotal)
+    {
+        unsigned long long nInterval = SEARCH_CHECK_INTERVAL;
+        if (m_limits.nMaxNodes > 0)
+        {
+            unsigned long long nLeft = nTotal < m_limits.nMaxNodes ? m_limits.nMaxNodes - nTotal : 0;
+            if (nLeft < nInterval)
+                nInterval = nLeft + 1;
+        }
+        m_nInterval = (unsigned)nInterval;
+        m_nCountdown = m_nInterval;
+    }
+
+    bool SearchBudget::check(unsigned nNodes)
+    {
+        if (m_stop != STOP_NONE)
+            return true;
+
+        unsigned long long nSpent = m_nInterval - m_nCountdown + nNodes;
+        m_nNodes += nSpent;
+        unsigned long long nTotal = m_pSharedNodes
+            ? m_pSharedNodes->fetch_add(nSpent, std::memory_order_relaxed) + nSpent : m_nNodes;
+
+        if (m_limits.nMaxNodes > 0 && nTotal > m_limits.nMaxNodes)
+            stop(STOP_NODE_LIMIT);
+        else if ((m_limits.pCancel && m_limits.pCancel->load(std::memory_order_relaxed))
+              || (m_pSharedStop && m_pSharedStop->load(std::memory_order_relaxed) != STOP_NONE))
+            stop(STOP_CANCELLED);
+        else if (m_limits.deadline != std::chrono::steady_clock::time_point::max()
+              && std::chrono::steady_clock::now() >= m_limits.deadline)
+            stop(STOP_DEADLINE);
+
+        if (m_stop != STOP_NONE)
+            return true;
+
+        startInterval(nTotal);
+        return false;
+    }
+
+    void SearchBudget::stop(SearchStop reason)
+    {
+        if (m_stop != STOP_NONE)
+            return;
+
+        // a node limit of its own only stops this search
+        m_stop = reason;
+        m_nCountdown = 0;
+        SearchStop none = STOP_NONE;
+        if (m_pSharedStop && (reason != STOP_NODE_LIMIT || m_pSharedNodes))
+            m_pSharedStop->compare_exchange_strong(none, reason);
+    }
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+namespace KSudoku {
+
+    // What a search may spend before it gives up: a time, a number of nodes and a flag another
+    // thread raises to cancel it. Any of them may be left out.
+    struct SearchLimits {
+        std::chrono::steady_clock::time_point   deadline;   // time_point::max() for none
+        unsigned long long                      nMaxNodes;  // 0 for no limit
+        const std::atomic<bool>*                pCancel;    // NULL for none
+    };
+
+    // no deadline, no node limit and nothing to cancel
+    SearchLimits NoSearchLimits();
+
+    // the limits with a deadline the given number of milliseconds from now
+    SearchLimits SearchLimitsIn(long long nMilliseconds);
+
+    enum SearchStop {
+        STOP_NONE,
+        STOP_DEADLINE,
+        STOP_NODE_LIMIT,
+        STOP_CANCELLED
+    };
+
+    const char* SearchStopName(SearchStop reason);
+
+    // the nodes between two looks at the clock and the cancel flag
+    const unsigned SEARCH_CHECK_INTERVAL = 1024;
+
+    // The limits of one search as it runs. The solvers spend() every node they place, which only
+    // counts down, and once every SEARCH_CHECK_INTERVAL nodes the budget looks at the clock and
+    // the cancel flag, so a search costs nothing more that way and gives up within about a
+    // thousand nodes of its deadline. The node limit is exact.
+    //
+    // The searches of several threads working on one puzzle share their limits with a node
+    // counter and a stop reason of their own: the nodes of all of them count against the limit,
+    // and the first one to stop sets the reason, which stops the others as cancelled. The limit
+    // is only seen at the looks then, each thread may go up to one interval past it, and a
+    // search which ends has to flush() the nodes it spent since its last look. Without a
+    // shared counter each search has the node limit to itself, and running out of it stops no
+    // other.
+    //
+    class SearchBudget {
+    public:
+        explicit SearchBudget(const SearchLimits& limits);
+        SearchBudget(const SearchLimits& limits, std::atomic<unsigned long long>* pSharedNodes,
+                     std::atomic<SearchStop>* pSharedStop);
+
+        // counts nNodes more nodes, true once the search has to give up, and from then on
+        bool spend(unsigned nNodes = 1)
+        {
+            if (m_nCountdown > nNodes)
+            {
+                m_nCountdown -= nNodes;
+                return false;
+            }
+            return check(nNodes);
+        }
+
+        void stop(SearchStop reason);       // gives up for the reason, unless it already has
+
+        // counts the nodes of the current interval at once and looks at the limits, for a search
+        // which ends before its next look while others share its node counter; true if it has to
+        // give up
+        bool flush()                        { return check(0); }
+
+        bool                stopped() const     { return m_stop != STOP_NONE; }
+        SearchStop          reason() const      { return m_stop; }
+        const SearchLimits& limits() const      { return m_limits; }
+
+    private:
+        bool check(unsigned nNodes);
+        void startInterval(unsigned long long nTotal);
+
+    private:
+        SearchLimits                        m_limits;
+        std::atomic<unsigned long long>*    m_pSharedNodes;
+        std::atomic<SearchStop>*            m_pSharedStop;
+        unsigned long long                  m_nNodes;       // spent before the current interval
+        unsigned                            m_nInterval;    // the nodes the current interval started with
+        unsigned                            m_nCountdown;   // and those left of it
+        SearchStop                          m_stop;
+    };
+}
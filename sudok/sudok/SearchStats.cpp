@@ -0,0 +1,59 @@
+#include "stdafx.h"
+#include "SearchStats.h"
+#include <stdio.h>
+
+namespace KSudoku {
+
+    SearchStats::SearchStats()
+        : nNodes(0), nBacktracks(0), nValidations(0), nBranches(0), nCandidates(0),
+          nBoxSolutions(0), nBandSolutions(0), nPeakSolutions(0)
+    {
+        for (int k = 0; k < PHASE_COUNT; k++)
+            phaseSeconds[k] = 0;
+    }
+
+    void SearchStats::add(const SearchStats& other)
+    {
+        nNodes += other.nNodes;
+        nBacktracks += other.nBacktracks;
+        nValidations += other.nValidations;
+        nBranches += other.nBranches;
+        nCandidates += other.nCandidates;
+        nBoxSolutions += other.nBoxSolutions;
+        nBandSolutions += other.nBandSolutions;
+        if (other.nPeakSolutions > nPeakSolutions)
+            nPeakSolutions = other.nPeakSolutions;
+        for (int k = 0; k < PHASE_COUNT; k++)
+            phaseSeconds[k] += other.phaseSeconds[k];
+    }
+
+    void SearchStats::print(FILE* file) const
+    {
+        static const char* const PHASE_NAMES[PHASE_COUNT] = {
+            "parse", "prepare", "search", "box enumeration", "band join", "final assembly"
+        };
+
+#if KSUDOKU_STATS
+        fprintf(file, "nodes            %llu\n", nNodes);
+        fprintf(file, "backtracks       %llu\n", nBacktracks);
+        fprintf(file, "validations      %llu\n", nValidations);
+        fprintf(file, "branches         %llu, %.2f candidates on average\n",
+            nBranches, nBranches ? (double)nCandidates / nBranches : 0.0);
+        if (nBoxSolutions || nBandSolutions)
+        {
+            fprintf(file, "box solutions    %llu\n", nBoxSolutions);
+            fprintf(file, "band solutions   %llu\n", nBandSolutions);
+            fprintf(file, "peak list        %llu solutions\n", nPeakSolutions);
+        }
+        for (int k = 0; k < PHASE_COUNT; k++)
+        {
+            if (phaseSeconds[k] > 0)
+                fprintf(file, "%-16s %.3f ms\n", PHASE_NAMES[k], phaseSeconds[k] * 1e3);
+        }
+#else
+        (void)PHASE_NAMES;
+        fprintf(file, "the stats are compiled out, build with KSUDOKU_STATS=1\n");
+#endif
+    }
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdio.h>
+#include <chrono>
+
+// The searches count what they do only when KSUDOKU_STATS is 1, the default. Built with
+// KSUDOKU_STATS=0 the counters and timers below compile to nothing and a SearchStats stays zero.
+#ifndef KSUDOKU_STATS
+#define KSUDOKU_STATS 1
+#endif
+
+#if KSUDOKU_STATS
+#define KSUDOKU_COUNT(statement)    statement
+#else
+#define KSUDOKU_COUNT(statement)
+#endif
+
+namespace KSudoku {
+
+    enum SearchPhase {
+        PHASE_PARSE,                // reading the puzzle into a table
+        PHASE_PREPARE,              // filling the singles and setting up the solver
+        PHASE_SEARCH,               // the search of the backtracking, mrv and dlx solvers
+        PHASE_BOX_ENUMERATION,      // the permutations of the sub-regions
+        PHASE_BAND_JOIN,            // joining the sub-regions into sub region rows
+        PHASE_ASSEMBLY,             // joining the sub region rows into whole tables
+        PHASE_COUNT
+    };
+
+    // What a search did to find its answer, filled in by the solvers which take one. A node is a
+    // value placed by the search, the const cells and the cells filled by Propagate are not
+    // counted. Solvers add to the counters, so one SearchStats can sum up many puzzles.
+    //
+    struct SearchStats {
+        SearchStats();
+        void add(const SearchStats& other);
+        void print(FILE* file) const;
+
+        unsigned long long  nNodes;
+        unsigned long long  nBacktracks;        // values taken back out of a cell
+        unsigned long long  nValidations;       // legality checks, of a cell or of a join
+        unsigned long long  nBranches;          // cells (or dlx columns) chosen to branch on
+        unsigned long long  nCandidates;        // their candidates, nCandidates / nBranches on average
+        unsigned long long  nBoxSolutions;      // sub-region solutions of the permutation solver
+        unsigned long long  nBandSolutions;     // its sub region row solutions
+        unsigned long long  nPeakSolutions;     // the longest list of either, kept as a maximum
+        double              phaseSeconds[PHASE_COUNT];
+    };
+
+    // Adds the time from its construction to its destruction to one phase of the stats, or does
+    // nothing if there are no stats.
+#if KSUDOKU_STATS
+    class PhaseTimer {
+    public:
+        PhaseTimer(SearchStats* pStats, SearchPhase phase) : m_pStats(pStats), m_phase(phase)
+        {
+            if (m_pStats)
+                m_start = std::chrono::steady_clock::now();
+        }
+        ~PhaseTimer()
+        {
+            if (m_pStats)
+                m_pStats->phaseSeconds[m_phase] += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+    private:
+        SearchStats*                            m_pStats;
+        SearchPhase                             m_phase;
+        std::chrono::steady_clock::time_point   m_start;
+    };
+#else
+    class PhaseTimer {
+    public:
+        PhaseTimer(SearchStats*, SearchPhase) {}
+    };
+#endif
+
+}
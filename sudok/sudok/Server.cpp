@@ -0,0 +1,397 @@
+#include "stdafx.h"
+#include "Server.h"
+#include "Solver.h"
+#include "SolutionCache.h"
+#include "ThreadPool.h"
+#include "SearchStats.h"
+#include "PuzzleFile.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace KSudoku {
+
+    const int SERVE_MAX_LINE = 1024;        // longer request lines are answered as invalid
+
+    // One client. Its requests are read on one thread and solved by the workers, which queue
+    // their answers for a second thread to write, so a worker never waits on a slow client.
+    // At most nMaxPending requests are read and not written back yet, then the reader waits,
+    // the connection fills up and holds back the client alone.
+    //
+    struct ServeConnection {
+        ServeConnection(FILE* inFile, FILE* outFile, int nMaxPendingRequests)
+            : in(inFile), out(outFile), nMaxPending(nMaxPendingRequests > 0 ? nMaxPendingRequests : 1),
+              nPending(0), nQueued(0), bReadDone(false)
+        {
+        }
+
+        FILE*                   in;
+        FILE*                   out;
+        int                     nMaxPending;
+
+        std::mutex              mutex;
+        std::condition_variable changed;
+        std::string             answers;        // the answers not written yet, one per line
+        int                     nPending;       // guarded by mutex, read and not written back
+        int                     nQueued;        // guarded by mutex, the answers in the queue
+        bool                    bReadDone;      // guarded by mutex
+        TaskGroup               group;          // the requests being solved
+    };
+
+    struct ServeRequest {
+        std::string                             id;
+        char                                    cells[81];
+        std::chrono::steady_clock::time_point   deadline;
+    };
+
+    // The workers and the cache, shared by all the connections. The workers
+    // live as long as the server, each with its own stats, and the solvers keep nothing on the
+    // heap, so a request costs its parsing, a task and the solve.
+    //
+    class PuzzleServer {
+    public:
+        PuzzleServer(const ServeOptions& options, bool bStats)
+            : m_pool(options.nThreads), m_nMaxPending(options.nMaxPending), m_nTimeoutMs(options.nTimeoutMs),
+              m_nMaxNodes(options.nMaxNodes), m_workerStats(m_pool.numWorkers()), m_bStats(bStats),
+              m_nConnections(0), m_nRequests(0), m_nSolved(0), m_nGivenUp(0)
+        {
+            if (options.nCacheEntries > 0)
+                m_cache.reset(new SolutionCache(options.nCacheEntries, m_pool.numWorkers() * 4));
+        }
+
+        // reads the requests of a connection until it ends, and writes their answers
+        void serve(FILE* in, FILE* out);
+        int  listen(const char* socketPath);
+
+        void printSummary(double seconds) const;
+        void addStats(SearchStats& stats) const;
+
+    private:
+        void read(ServeConnection& connection);
+        void write(ServeConnection& connection);
+        void solve(ServeConnection& connection, const ServeRequest& request, int nWorker);
+        void answer(ServeConnection& connection, const char* id, size_t nId, const char* text, size_t nText);
+
+    private:
+        WorkStealingPool                m_pool;
+        int                             m_nMaxPending;
+        long long                       m_nTimeoutMs;
+        unsigned long long              m_nMaxNodes;
+        std::unique_ptr<SolutionCache>  m_cache;
+        std::vector<SearchStats>        m_workerStats;
+        bool                            m_bStats;
+
+        std::mutex                      m_mutex;
+        std::condition_variable         m_connectionClosed;
+        int                             m_nConnections;     // guarded by m_mutex
+        std::atomic<long long>          m_nRequests;
+        std::atomic<long long>          m_nSolved;
+        std::atomic<long long>          m_nGivenUp;         // timed out or past the node limit
+    };
+
+    void PuzzleServer::answer(ServeConnection& connection, const char* id, size_t nId, const char* text, size_t nText)
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        connection.answers.append(id, nId);
+        connection.answers.push_back(' ');
+        connection.answers.append(text, nText);
+        connection.answers.push_back('\n');
+        connection.nQueued++;
+        connection.changed.notify_all();
+    }
+
+    // Writes the queued answers as they come, all of those queued at once in one go, and
+    // flushes them right away as the client may wait for them before sending more. Once the
+    // client is gone the answers are still taken off the queue, so the reader never waits.
+    //
+    void PuzzleServer::write(ServeConnection& connection)
+    {
+        std::string answers;
+        bool bBroken = false;
+        std::unique_lock<std::mutex> lock(connection.mutex);
+        for (;;)
+        {
+            connection.changed.wait(lock, [&connection] {
+                return connection.nQueued > 0 || (connection.bReadDone && connection.nPending == 0);
+            });
+            if (connection.nQueued == 0)
+                break;
+
+            answers.swap(connection.answers);
+            int nAnswers = connection.nQueued;
+            connection.nQueued = 0;
+            lock.unlock();
+
+            if (!bBroken)
+            {
+                bBroken = fwrite(answers.data(), 1, answers.size(), connection.out) != answers.size()
+                       || fflush(connection.out) != 0;
+            }
+            answers.clear();
+
+            lock.lock();
+            connection.nPending -= nAnswers;
+            connection.changed.notify_all();
+        }
+    }
+
+    void PuzzleServer::solve(ServeConnection& connection, const ServeRequest& request, int nWorker)
+    {
+        SearchStats* pStats = m_bStats ? &m_workerStats[nWorker] : nullptr;
+        SolveOptions options = DefaultSolveOptions();
+        options.limits.deadline = request.deadline;
+        options.limits.nMaxNodes = m_nMaxNodes;
+        char solution[81];
+        SolveStatus status = m_cache ? SolveGridCached(*m_cache, request.cells, solution, &options, pStats)
+                                     : SolveGrid(request.cells, solution, &options, pStats);
+
+        const char* id = request.id.data();
+        size_t nId = request.id.size();
+        if (status == SOLVE_SOLVED)
+        {
+            char text[81];
+            for (int i = 0; i < 81; i++)
+                text[i] = (char)('0' + solution[i]);
+            answer(connection, id, nId, text, sizeof(text));
+            m_nSolved++;
+        }
+        else if (status == SOLVE_NO_SOLUTION)
+        {
+            static const char NO_SOLUTION[] = "no solution";
+            answer(connection, id, nId, NO_SOLUTION, sizeof(NO_SOLUTION) - 1);
+        }
+        else if (status != SOLVE_INVALID_PUZZLE)
+        {
+            const char* text = SolveStatusName(status);
+            answer(connection, id, nId, text, strlen(text));
+            m_nGivenUp++;
+        }
+        else
+        {
+            static const char INVALID[] = "invalid a digit given twice in a row, column or sub-region";
+            answer(connection, id, nId, INVALID, sizeof(INVALID) - 1);
+        }
+    }
+
+    void PuzzleServer::read(ServeConnection& connection)
+    {
+        char line[SERVE_MAX_LINE];
+        while (fgets(line, sizeof(line), connection.in))
+        {
+            size_t nLength = strlen(line);
+            bool bTooLong = nLength == sizeof(line) - 1 && line[nLength - 1] != '\n';
+            if (bTooLong)
+            {
+                int c;
+                while ((c = getc(connection.in)) != EOF && c != '\n')
+                    ;
+            }
+
+            const char* p = line;
+            while (*p == ' ' || *p == '\t')
+                p++;
+            if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#')
+                continue;
+
+            const char* id = p;
+            while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                p++;
+            size_t nId = p - id;
+            m_nRequests++;
+
+            {
+                std::unique_lock<std::mutex> lock(connection.mutex);
+                connection.changed.wait(lock, [&connection] { return connection.nPending < connection.nMaxPending; });
+                connection.nPending++;
+            }
+
+            const char* pError = nullptr;
+            ServeRequest request;
+            if (bTooLong)
+            {
+                pError = "line too long";
+            }
+            else
+            {
+                PuzzleParser parser(p, line + nLength);
+                ParseResult result = parser.next(request.cells);
+                if (result == PARSE_END)
+                    pError = "no puzzle";
+                else if (result == PARSE_MALFORMED)
+                    pError = parser.error();
+            }
+            if (pError)
+            {
+                char text[256];
+                int nText = snprintf(text, sizeof(text), "invalid %s", pError);
+                answer(connection, id, nId, text, nText < (int)sizeof(text) ? nText : sizeof(text) - 1);
+                continue;
+            }
+
+            request.id.assign(id, nId);
+            request.deadline = m_nTimeoutMs > 0
+                ? std::chrono::steady_clock::now() + std::chrono::milliseconds(m_nTimeoutMs)
+                : std::chrono::steady_clock::time_point::max();
+            ServeConnection* pConnection = &connection;
+            m_pool.submit(connection.group, [this, pConnection, request](int nWorker) {
+                solve(*pConnection, request, nWorker);
+            });
+        }
+
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        connection.bReadDone = true;
+        connection.changed.notify_all();
+    }
+
+    void PuzzleServer::serve(FILE* in, FILE* out)
+    {
+        ServeConnection connection(in, out, m_nMaxPending);
+        std::thread writer(&PuzzleServer::write, this, std::ref(connection));
+        read(connection);
+        writer.join();
+        connection.group.wait();
+    }
+
+#ifdef _WIN32
+
+    int PuzzleServer::listen(const char* socketPath)
+    {
+        fprintf(stderr, "can't serve %s, only stdin is served on Windows\n", socketPath);
+        return -1;
+    }
+
+#else
+
+    // Every connection is read and written on its own two threads, which end with it, and all
+    // of them share the workers. Runs until the socket fails, usually until the process is stopped.
+    //
+    int PuzzleServer::listen(const char* socketPath)
+    {
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(socketPath) >= sizeof(address.sun_path))
+        {
+            fprintf(stderr, "socket path too long: %s\n", socketPath);
+            return -1;
+        }
+        strcpy(address.sun_path, socketPath);
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+        {
+            perror("socket");
+            return -1;
+        }
+        unlink(socketPath);
+        if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0)
+        {
+            fprintf(stderr, "can't listen on %s: %s\n", socketPath, strerror(errno));
+            close(listener);
+            return -1;
+        }
+
+        // a client gone before its answers shouldn't stop the server
+        signal(SIGPIPE, SIG_IGN);
+        fprintf(stderr, "serving %s with %d threads\n", socketPath, m_pool.numWorkers());
+
+        for (;;)
+        {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                perror("accept");
+                break;
+            }
+
+            int fdOut = dup(fd);
+            FILE* in = fdopen(fd, "r");
+            FILE* out = fdOut >= 0 ? fdopen(fdOut, "w") : nullptr;
+            if (!in || !out)
+            {
+                if (in) fclose(in); else close(fd);
+                if (out) fclose(out); else if (fdOut >= 0) close(fdOut);
+                continue;
+            }
+            setvbuf(out, NULL, _IOFBF, 1 << 16);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_nConnections++;
+            }
+            std::thread([this, in, out] {
+                serve(in, out);
+                fclose(in);
+                fclose(out);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (--m_nConnections == 0)
+                    m_connectionClosed.notify_all();
+            }).detach();
+        }
+
+        close(listener);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_connectionClosed.wait(lock, [this] { return m_nConnections == 0; });
+        return -1;
+    }
+
+#endif
+
+    void PuzzleServer::printSummary(double seconds) const
+    {
+        long long nRequests = m_nRequests.load();
+        fprintf(stderr, "%lld requests, %lld solved in %.3f s, %.0f requests/second\n",
+            nRequests, m_nSolved.load(), seconds, seconds > 0 ? nRequests / seconds : 0.0);
+        if (m_nGivenUp.load() > 0)
+            fprintf(stderr, "%lld given up at the time or node limit\n", m_nGivenUp.load());
+        if (m_cache)
+            fprintf(stderr, "cache: %llu hits, %llu misses\n", m_cache->hits(), m_cache->misses());
+    }
+
+    void PuzzleServer::addStats(SearchStats& stats) const
+    {
+        for (size_t k = 0; k < m_workerStats.size(); k++)
+            stats.add(m_workerStats[k]);
+    }
+
+    int ServePuzzles(const ServeOptions& options, SearchStats* pStats)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        PuzzleServer server(options, pStats != nullptr);
+
+        int result = 0;
+        if (options.socketPath)
+        {
+            result = server.listen(options.socketPath);
+        }
+        else
+        {
+            setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+            server.serve(stdin, stdout);
+        }
+
+        server.printSummary(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if (pStats)
+            server.addStats(*pStats);
+        return result;
+    }
+
+}
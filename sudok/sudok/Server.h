@@ -0,0 +1,33 @@
+#pragma once
+#include <stddef.h>
+
+namespace KSudoku {
+    struct SearchStats;
+
+    struct ServeOptions {
+        int                 nThreads;
+        const char*         socketPath;     // the Unix domain socket to listen on, NULL to serve stdin
+        size_t              nCacheEntries;  // solutions kept in a SolutionCache, 0 for no cache
+        int                 nMaxPending;    // requests of a connection read and not answered yet, reading waits beyond that
+        long long           nTimeoutMs;     // the time from reading a request to giving up on it, 0 for no limit
+        unsigned long long  nMaxNodes;      // the nodes the search of a request may take, 0 for no limit
+    };
+
+    // Serves puzzles until the input ends, over stdin and stdout or over every connection to a
+    // Unix domain socket. Each line is a request, an id then the puzzle in one line (see
+    // PuzzleParser), and gets one line back with the same id, as soon as it is solved:
+    //
+    //   7 3...679..1...8925..65.4.3....2....3.8.6..317.......4.5...7..6.....4...1..89.3..2.
+    //   7 328567941174389256965241387512674839846953172793812465451728693237496518689135724
+    //
+    // or "<id> no solution", or "<id> invalid <why>", or "<id> timed out" or "<id> node limit
+    // reached" when the search gives up, the time counting from when the request is read so the
+    // wait for a worker is part of it. Blank lines and lines starting with "#" get no answer.
+    // A connection may send any number of requests without waiting, they are
+    // solved on a pool of nThreads workers shared by all the connections, so the answers come
+    // in the order they are solved, not sent. A client which sends without reading its answers
+    // is held back once nMaxPending of them are waiting, the others go on. The stats of all the
+    // puzzles are added to pStats unless it is NULL.
+    // Returns -1 if the socket can't be opened, 0 once stdin ends.
+    int ServePuzzles(const ServeOptions& options, SearchStats* pStats);
+}
@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "SolutionCache.h"
+#include "Canonical.h"
+#include <string.h>
+
+namespace KSudoku {
+
+    bool SolutionCache::Key::operator==(const Key& other) const
+    {
+        return memcmp(cells, other.cells, sizeof(cells)) == 0;
+    }
+
+    // FNV-1a over the 81 cells
+    size_t SolutionCache::KeyHash::operator()(const Key& key) const
+    {
+        unsigned long long h = 14695981039346656037ull;
+        for (int n = 0; n < 81; n++)
+        {
+            h ^= (unsigned char)key.cells[n];
+            h *= 1099511628211ull;
+        }
+        return (size_t)h;
+    }
+
+    SolutionCache::SolutionCache(size_t nCapacity, int nShards)
+        : m_nHits(0), m_nMisses(0)
+    {
+        if (nShards < 1)
+            nShards = 1;
+        if (nCapacity < (size_t)nShards)
+            nCapacity = nShards;
+
+        for (int k = 0; k < nShards; k++)
+        {
+            m_shards.push_back(std::unique_ptr<Shard>(new Shard()));
+            m_shards.back()->nCapacity = (nCapacity + nShards - 1) / nShards;
+            m_shards.back()->index.reserve(m_shards.back()->nCapacity);
+        }
+    }
+
+    SolutionCache::Shard& SolutionCache::shardOf(size_t hash)
+    {
+        // folded, the low bits alone also pick the bucket within the shard
+        return *m_shards[((hash >> 16) ^ hash) % m_shards.size()];
+    }
+
+    bool SolutionCache::lookup(const char canonical[81], char solution[81], SolveStatus& status)
+    {
+        Key key;
+        memcpy(key.cells, canonical, sizeof(key.cells));
+        Shard& shard = shardOf(KeyHash()(key));
+
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end())
+        {
+            m_nMisses++;
+            return false;
+        }
+
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        memcpy(solution, it->second->solution, sizeof(it->second->solution));
+        status = it->second->status;
+        m_nHits++;
+        return true;
+    }
+
+    void SolutionCache::insert(const char canonical[81], const char solution[81], SolveStatus status)
+    {
+        Key key;
+        memcpy(key.cells, canonical, sizeof(key.cells));
+        Shard& shard = shardOf(KeyHash()(key));
+
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;     // another worker solved it first
+        }
+
+        // a full shard reuses the node of its least recently used entry
+        if (shard.entries.size() >= shard.nCapacity)
+        {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.splice(shard.entries.begin(), shard.entries, std::prev(shard.entries.end()));
+        }
+        else
+        {
+            shard.entries.push_front(Entry());
+        }
+
+        Entry& entry = shard.entries.front();
+        entry.key = key;
+        memcpy(entry.solution, solution, sizeof(entry.solution));
+        entry.status = status;
+        shard.index[key] = shard.entries.begin();
+    }
+
+    SolveStatus SolveGridCached(SolutionCache& cache, const char puzzle[81], char solution[81],
+                                const SolveOptions* pOptions, SearchStats* pStats)
+    {
+        if (!puzzle || !solution)
+            return SOLVE_INVALID_ARGUMENT;
+        for (int n = 0; n < 81; n++)
+        {
+            if (puzzle[n] < 0 || puzzle[n] > 9)
+                return SOLVE_INVALID_PUZZLE;
+        }
+
+        GridTransform transform;
+        char canonical[81];
+        CanonicalizeGrid(puzzle, canonical, transform);
+
+        char canonicalSolution[81];
+        SolveStatus status;
+        if (!cache.lookup(canonical, canonicalSolution, status))
+        {
+            status = SolveGrid(canonical, canonicalSolution, pOptions, pStats);
+            if (status != SOLVE_SOLVED && status != SOLVE_NO_SOLUTION)
+                return status;
+            if (status == SOLVE_NO_SOLUTION)
+                memset(canonicalSolution, 0, sizeof(canonicalSolution));
+            cache.insert(canonical, canonicalSolution, status);
+        }
+
+        if (status == SOLVE_SOLVED)
+            UntransformGrid(transform, canonicalSolution, solution);
+        return status;
+    }
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Solver.h"
+
+namespace KSudoku {
+
+    // The solutions of canonical puzzles (see Canonical.h), at most nCapacity of them, the least
+    // recently used one going when a new one comes. The cache is cut into shards, each with its
+    // own lock and its own share of the capacity, so the workers of a batch rarely wait on
+    // each other. Puzzles without a solution are kept too.
+    //
+    class SolutionCache {
+    public:
+        SolutionCache(size_t nCapacity, int nShards);
+
+        // copies the solution of a canonical puzzle, false if it isn't in the cache
+        bool lookup(const char canonical[81], char solution[81], SolveStatus& status);
+        void insert(const char canonical[81], const char solution[81], SolveStatus status);
+
+        unsigned long long hits() const     { return m_nHits.load(); }
+        unsigned long long misses() const   { return m_nMisses.load(); }
+
+    private:
+        struct Key {
+            char cells[81];
+            bool operator==(const Key& other) const;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            Key         key;
+            char        solution[81];
+            SolveStatus status;
+        };
+
+        typedef std::list<Entry> EntryList;
+
+        struct Shard {
+            std::mutex                                              lock;
+            EntryList                                               entries;    // the most recently used first
+            std::unordered_map<Key, EntryList::iterator, KeyHash>   index;
+            size_t                                                  nCapacity;
+        };
+
+        Shard& shardOf(size_t hash);
+
+    private:
+        std::vector<std::unique_ptr<Shard> >    m_shards;
+        std::atomic<unsigned long long>         m_nHits;
+        std::atomic<unsigned long long>         m_nMisses;
+    };
+
+    // Solves the puzzle like SolveGrid, but through the cache: the puzzle is canonicalized, a
+    // cached solution of its canonical form is mapped back through the inverse transform, and
+    // a new one is solved on the canonical form and cached. pStats only counts the solves.
+    SolveStatus SolveGridCached(SolutionCache& cache, const char puzzle[81], char solution[81],
+                                const SolveOptions* pOptions, SearchStats* pStats);
+}
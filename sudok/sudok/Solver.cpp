@@ -0,0 +1,140 @@
+#include "stdafx.h"
+#include "Solver.h"
+#include "Board.h"
+#include "Propagation.h"
+#include "BackTracking.h"
+#include "BitMask.h"
+#include "MRV.h"
+#include "DLX.h"
+#include "Count.h"
+#include "SearchStats.h"
+#include <string.h>
+
+namespace KSudoku {
+
+    struct EngineName {
+        const char*     name;
+        SolverEngine    engine;
+    };
+
+    const EngineName ENGINE_NAMES[] = {
+        { "backtracking",   ENGINE_BACKTRACKING },
+        { "bitmask",        ENGINE_BITMASK },
+        { "mrv",            ENGINE_MRV },
+        { "dlx",            ENGINE_DLX },
+    };
+
+    SolveOptions DefaultSolveOptions()
+    {
+        SolveOptions options;
+        options.engine = ENGINE_MRV;
+        options.bPropagate = true;
+        options.limits = NoSearchLimits();
+        return options;
+    }
+
+    // Everything lives on the stack of the call: the board, 146 bytes, and the engine's own
+    // state, the fixed 81 entry trail of mrv or the 40KB of dancing links.
+    //
+    SolveStatus SolveGrid(const char puzzle[81], char solution[81], const SolveOptions* pOptions, SearchStats* pStats)
+    {
+        if (!puzzle || !solution)
+            return SOLVE_INVALID_ARGUMENT;
+
+        SolveOptions options = pOptions ? *pOptions : DefaultSolveOptions();
+
+        Board board;
+        {
+            PhaseTimer timer(pStats, PHASE_PREPARE);
+            if (!LoadBoard(board, puzzle))
+                return SOLVE_INVALID_PUZZLE;
+            if (options.bPropagate && !Propagate(board))
+                return SOLVE_NO_SOLUTION;
+        }
+
+        SearchBudget budget(options.limits);
+        bool bSolved;
+        switch (options.engine)
+        {
+        case ENGINE_BACKTRACKING:
+            bSolved = SearchBackTracking(board, &budget, pStats);
+            break;
+        case ENGINE_BITMASK:
+            bSolved = SearchBitMask(board, &budget, pStats);
+            break;
+        case ENGINE_MRV:
+            bSolved = SearchMRV(board, &budget, pStats);
+            break;
+        case ENGINE_DLX:
+            bSolved = SearchDLX(board, &budget, pStats);
+            break;
+        default:
+            return SOLVE_INVALID_ARGUMENT;
+        }
+
+        if (budget.stopped())
+            return StoppedStatus(budget.reason());
+        if (!bSolved || !VerifySolution(board))
+            return SOLVE_NO_SOLUTION;
+
+        StoreBoard(board, solution);
+        return SOLVE_SOLVED;
+    }
+
+    SolveStatus CountGridSolutions(const char puzzle[81], int nLimit, int* pCount, const SearchLimits* pLimits,
+                                   SearchStats* pStats)
+    {
+        if (!puzzle || !pCount || nLimit < 1)
+            return SOLVE_INVALID_ARGUMENT;
+
+        *pCount = 0;
+        Board board;
+        if (!LoadBoard(board, puzzle))
+            return SOLVE_INVALID_PUZZLE;
+
+        SearchBudget budget(pLimits ? *pLimits : NoSearchLimits());
+        *pCount = CountSolutions(board, nLimit, &budget, pStats);
+        if (budget.stopped())
+            return StoppedStatus(budget.reason());
+        return *pCount > 0 ? SOLVE_SOLVED : SOLVE_NO_SOLUTION;
+    }
+
+    SolveStatus StoppedStatus(SearchStop reason)
+    {
+        switch (reason)
+        {
+        case STOP_DEADLINE:     return SOLVE_TIMED_OUT;
+        case STOP_NODE_LIMIT:   return SOLVE_NODE_LIMIT;
+        default:                return SOLVE_CANCELLED;
+        }
+    }
+
+    const char* SolveStatusName(SolveStatus status)
+    {
+        switch (status)
+        {
+        case SOLVE_SOLVED:              return "solved";
+        case SOLVE_NO_SOLUTION:         return "no solution";
+        case SOLVE_INVALID_PUZZLE:      return "invalid puzzle";
+        case SOLVE_INVALID_ARGUMENT:    return "invalid argument";
+        case SOLVE_TIMED_OUT:           return "timed out";
+        case SOLVE_NODE_LIMIT:          return "node limit reached";
+        case SOLVE_CANCELLED:           return "cancelled";
+        }
+        return "unknown";
+    }
+
+    bool FindSolverEngine(const char* name, SolverEngine& engine)
+    {
+        for (size_t k = 0; k < sizeof(ENGINE_NAMES) / sizeof(ENGINE_NAMES[0]); k++)
+        {
+            if (strcmp(name, ENGINE_NAMES[k].name) == 0)
+            {
+                engine = ENGINE_NAMES[k].engine;
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "SearchBudget.h"
+
+namespace KSudoku {
+    struct SearchStats;
+
+    // The library interface of the solvers, for programs which embed them: a puzzle goes in as
+    // 81 bytes, the solution comes out in a buffer of the caller, and nothing is printed,
+    // allocated on the heap or kept between calls, so any number of threads can solve at once.
+    // A grid is 81 cells row by row, each 0 ~ 9 with 0 for a null cell (not the characters
+    // '0' ~ '9'), the cells a PuzzleParser gives.
+
+    enum SolveStatus {
+        SOLVE_SOLVED,
+        SOLVE_NO_SOLUTION,
+        SOLVE_INVALID_PUZZLE,       // a cell out of 0 ~ 9, or a digit given twice in a row, column or sub-region
+        SOLVE_INVALID_ARGUMENT,     // a NULL grid or an unknown engine
+        SOLVE_TIMED_OUT,            // the search gave up at the deadline of the limits
+        SOLVE_NODE_LIMIT,           // or after their number of nodes
+        SOLVE_CANCELLED             // or when their cancel flag was raised
+    };
+
+    // the solvers which neither allocate nor start threads, the permutation and parallel ones do
+    enum SolverEngine {
+        ENGINE_BACKTRACKING,
+        ENGINE_BITMASK,
+        ENGINE_MRV,
+        ENGINE_DLX
+    };
+
+    struct SolveOptions {
+        SolverEngine    engine;
+        bool            bPropagate;     // fill the naked and hidden singles before the search
+        SearchLimits    limits;         // when the search gives up (see SearchBudget.h)
+    };
+
+    // mrv after the singles with no limits, what the batch mode does
+    SolveOptions DefaultSolveOptions();
+
+    // Solves the puzzle into solution, which is only written if the status is SOLVE_SOLVED.
+    // pOptions and pStats may be NULL, the stats are added to and belong to the caller, one per thread.
+    // A search which gives up returns SOLVE_TIMED_OUT, SOLVE_NODE_LIMIT or SOLVE_CANCELLED, with
+    // the stats of what it did until then.
+    SolveStatus SolveGrid(const char puzzle[81], char solution[81], const SolveOptions* pOptions, SearchStats* pStats);
+
+    // Counts the solutions of the puzzle up to nLimit, at least 1, into *pCount, 2 tells whether it is unique.
+    // pLimits may be NULL for none, *pCount is 0 if the search gives up.
+    SolveStatus CountGridSolutions(const char puzzle[81], int nLimit, int* pCount, const SearchLimits* pLimits,
+                                   SearchStats* pStats);
+
+    // the status of a search which gave up for the reason
+    SolveStatus StoppedStatus(SearchStop reason);
+
+    const char* SolveStatusName(SolveStatus status);
+
+    // the engine of a name, "backtracking", "bitmask", "mrv" or "dlx", false if there is none
+    bool FindSolverEngine(const char* name, SolverEngine& engine);
+}
@@ -0,0 +1,129 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+namespace KSudoku {
+
+    // the pool and the index of the worker running on this thread, if any
+    thread_local WorkStealingPool*  t_pPool = nullptr;
+    thread_local int                t_nWorker = -1;
+
+    void TaskGroup::done()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_nPending == 0)
+            m_allDone.notify_all();
+    }
+
+    void TaskGroup::wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_allDone.wait(lock, [this] { return m_nPending == 0; });
+    }
+
+    WorkStealingPool::WorkStealingPool(int nThreads)
+        : m_nQueued(0), m_bStop(false), m_nextQueue(0)
+    {
+        if (nThreads < 1)
+            nThreads = 1;
+
+        for (int i = 0; i < nThreads; i++)
+            m_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+
+        for (int i = 0; i < nThreads; i++)
+            m_threads.push_back(std::thread(&WorkStealingPool::run, this, i));
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_wakeUp.notify_all();
+
+        for (size_t i = 0; i < m_threads.size(); i++)
+            m_threads[i].join();
+    }
+
+    int WorkStealingPool::defaultThreadCount()
+    {
+        int n = (int)std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    void WorkStealingPool::submit(TaskGroup& group, const Task& task)
+    {
+        group.add();
+        Task groupTask = [&group, task](int nWorker) {
+            task(nWorker);
+            group.done();
+        };
+
+        int nQueue = (t_pPool == this) ? t_nWorker : (int)(m_nextQueue++ % m_queues.size());
+        {
+            WorkerQueue& queue = *m_queues[nQueue];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(groupTask);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_nQueued++;
+        }
+        m_wakeUp.notify_one();
+    }
+
+    bool WorkStealingPool::takeTask(int nWorker, Task& task)
+    {
+        int nQueues = (int)m_queues.size();
+        for (int i = 0; i < nQueues; i++)
+        {
+            int nQueue = (nWorker + i) % nQueues;
+            WorkerQueue& queue = *m_queues[nQueue];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                continue;
+
+            if (nQueue == nWorker)
+            {
+                // our own newest task, its data is most likely still in the cache
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                // steal the oldest task, which tends to be the biggest piece of work
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    void WorkStealingPool::run(int nWorker)
+    {
+        t_pPool = this;
+        t_nWorker = nWorker;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeUp.wait(lock, [this] { return m_nQueued > 0 || m_bStop; });
+                if (m_nQueued == 0)
+                    return;         // stopping and nothing left to do
+                m_nQueued--;
+            }
+
+            // a queued task is reserved for us, but it may sit in any deque
+            Task task;
+            while (!takeTask(nWorker, task))
+                std::this_thread::yield();
+
+            task(nWorker);
+        }
+    }
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace KSudoku {
+
+    // counts the tasks of one job so the submitter can wait for exactly those
+    class TaskGroup {
+    public:
+        TaskGroup() : m_nPending(0) {}
+
+        void add()      { std::lock_guard<std::mutex> lock(m_mutex); m_nPending++; }
+        void done();
+        void wait();
+
+    private:
+        std::mutex              m_mutex;
+        std::condition_variable m_allDone;
+        int                     m_nPending;
+    };
+
+    // A fixed set of worker threads, each with its own task deque. A worker takes the newest
+    // task of its own deque and, when that is empty, steals the oldest task of another one,
+    // so a few long tasks never hold back the short tasks queued behind them.
+    //
+    class WorkStealingPool {
+    public:
+        // the worker index lets a task use per-worker state, like its own table
+        typedef std::function<void(int nWorker)> Task;
+
+        explicit WorkStealingPool(int nThreads);
+        ~WorkStealingPool();
+
+        int  numWorkers() const { return (int)m_threads.size(); }
+
+        // a task submitted from a worker goes to the deque of that worker, others are spread round robin
+        void submit(TaskGroup& group, const Task& task);
+
+        static int defaultThreadCount();
+
+    private:
+        struct WorkerQueue {
+            std::mutex          mutex;
+            std::deque<Task>    tasks;
+        };
+
+        void run(int nWorker);
+        bool takeTask(int nWorker, Task& task);
+
+    private:
+        std::vector<std::unique_ptr<WorkerQueue>>   m_queues;
+        std::vector<std::thread>                    m_threads;
+        std::mutex                                  m_mutex;
+        std::condition_variable                     m_wakeUp;
+        int                                         m_nQueued;      // guarded by m_mutex
+        bool                                        m_bStop;        // guarded by m_mutex
+        std::atomic<unsigned int>                   m_nextQueue;
+    };
+
+}
@@ -0,0 +1,352 @@
+#include "stdafx.h"
+#include "Validator.h"
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define KSUDOKU_VALIDATOR_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define KSUDOKU_VALIDATOR_X86 0
+#endif
+
+// gcc and clang only emit the SIMD instructions in functions marked for them, msvc always does
+#if defined(__GNUC__)
+#define KSUDOKU_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KSUDOKU_TARGET(isa)
+#endif
+
+namespace KSudoku {
+
+    const unsigned int ALL_DIGIT_BITS = 0x1FF;
+
+    // The grid is valid when all its cells are 1 ~ 9 and the digits of each of the 27 units,
+    // ORed together as bits, make up all 9 bits: 9 cells can only do that with 9 different digits.
+    //
+    bool ValidateGridScalar(const unsigned char* grid)
+    {
+        unsigned int rows[9] = {};
+        unsigned int columns[9] = {};
+        unsigned int boxes[9] = {};
+
+        for (int n = 0; n < 81; n++)
+        {
+            unsigned int v = grid[n];
+            if (v - 1 > 8)
+                return false;
+
+            unsigned int bit = 1u << (v - 1);
+            rows[n / 9] |= bit;
+            columns[n % 9] |= bit;
+            boxes[n / 27 * 3 + n % 9 / 3] |= bit;
+        }
+
+        unsigned int all = ALL_DIGIT_BITS;
+        for (int k = 0; k < 9; k++)
+            all &= rows[k] & columns[k] & boxes[k];
+
+        return all == ALL_DIGIT_BITS;
+    }
+
+    size_t ValidateGridsScalar(const unsigned char* grids, size_t nGrids, unsigned char* results)
+    {
+        size_t nValid = 0;
+        for (size_t k = 0; k < nGrids; k++)
+        {
+            results[k] = ValidateGridScalar(grids + k * 81) ? 1 : 0;
+            nValid += results[k];
+        }
+        return nValid;
+    }
+
+#if KSUDOKU_VALIDATOR_X86
+
+    // The SIMD versions take the grid a row at a time: the 9 digits of a row are turned into
+    // their bits in 16-bit lanes with two byte shuffles (digits 1 ~ 8 give the low byte, 9 the
+    // high one), then ORed into the column and sub-region accumulators as whole vectors, while
+    // the row itself is ORed across its lanes. Rows 0 ~ 7 are loaded straight from the grid,
+    // row 8 from the last 16 bytes, shifted down, so nothing is read past the 81 bytes.
+
+    // the bits of the 8 lanes of lo plus lane 0 of hi, ORed to one unit mask
+    inline unsigned int UnitMask(const unsigned short lo[8], const unsigned short hi[8], int first, int n)
+    {
+        unsigned int mask = 0;
+        for (int k = first; k < first + n; k++)
+            mask |= k < 8 ? lo[k] : hi[0];
+        return mask;
+    }
+
+    KSUDOKU_TARGET("ssse3")
+    bool ValidateGridSSSE3(const unsigned char* grid)
+    {
+        const __m128i lutLow = _mm_setr_epi8(0, 1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i lutHigh = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0);
+        const __m128i one = _mm_set1_epi8(1);
+        const __m128i eight = _mm_set1_epi8(8);
+
+        __m128i columnsLow = _mm_setzero_si128();
+        __m128i columnsHigh = _mm_setzero_si128();
+        __m128i boxesLow = _mm_setzero_si128();
+        __m128i boxesHigh = _mm_setzero_si128();
+        unsigned short low[8];
+        unsigned short high[8];
+
+        unsigned int all = ALL_DIGIT_BITS;
+        int inRange = 0xFFFF;
+        for (int r = 0; r < 9; r++)
+        {
+            __m128i v = r < 8 ? _mm_loadu_si128((const __m128i*)(grid + 9 * r))
+                              : _mm_srli_si128(_mm_loadu_si128((const __m128i*)(grid + 65)), 7);
+
+            // 1 ~ 9 means v - 1 is at most 8 (0 wraps around to 255)
+            __m128i t = _mm_sub_epi8(v, one);
+            inRange &= _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(t, eight), eight));
+
+            __m128i bytesLow = _mm_shuffle_epi8(lutLow, v);
+            __m128i bytesHigh = _mm_shuffle_epi8(lutHigh, v);
+            __m128i bitsLow = _mm_unpacklo_epi8(bytesLow, bytesHigh);      // cells 0 ~ 7
+            __m128i bitsHigh = _mm_unpackhi_epi8(bytesLow, bytesHigh);     // cell 8 in lane 0
+
+            columnsLow = _mm_or_si128(columnsLow, bitsLow);
+            columnsHigh = _mm_or_si128(columnsHigh, bitsHigh);
+            boxesLow = _mm_or_si128(boxesLow, bitsLow);
+            boxesHigh = _mm_or_si128(boxesHigh, bitsHigh);
+
+            __m128i row = bitsLow;
+            row = _mm_or_si128(row, _mm_srli_si128(row, 8));
+            row = _mm_or_si128(row, _mm_srli_si128(row, 4));
+            row = _mm_or_si128(row, _mm_srli_si128(row, 2));
+            all &= (_mm_cvtsi128_si32(row) | _mm_cvtsi128_si32(bitsHigh)) & 0xFFFF;
+
+            if (r % 3 == 2)
+            {
+                _mm_storeu_si128((__m128i*)low, boxesLow);
+                _mm_storeu_si128((__m128i*)high, boxesHigh);
+                all &= UnitMask(low, high, 0, 3) & UnitMask(low, high, 3, 3) & UnitMask(low, high, 6, 3);
+                boxesLow = _mm_setzero_si128();
+                boxesHigh = _mm_setzero_si128();
+            }
+        }
+
+        _mm_storeu_si128((__m128i*)low, columnsLow);
+        _mm_storeu_si128((__m128i*)high, columnsHigh);
+        for (int j = 0; j < 9; j++)
+            all &= UnitMask(low, high, j, 1);
+
+        return (inRange & 0x1FF) == 0x1FF && all == ALL_DIGIT_BITS;
+    }
+
+    KSUDOKU_TARGET("ssse3")
+    size_t ValidateGridsSSSE3(const unsigned char* grids, size_t nGrids, unsigned char* results)
+    {
+        size_t nValid = 0;
+        for (size_t k = 0; k < nGrids; k++)
+        {
+            results[k] = ValidateGridSSSE3(grids + k * 81) ? 1 : 0;
+            nValid += results[k];
+        }
+        return nValid;
+    }
+
+    // The same as the SSSE3 version on two grids at once, one in each 128-bit half: the byte
+    // shuffles, unpacks and shifts of AVX2 all work within the halves.
+    //
+    KSUDOKU_TARGET("avx2")
+    void ValidateGridPairAVX2(const unsigned char* gridA, const unsigned char* gridB, unsigned char results[2])
+    {
+        const __m256i lutLow = _mm256_setr_epi8(0, 1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0,
+                                                0, 1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i lutHigh = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0,
+                                                 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0);
+        const __m256i one = _mm256_set1_epi8(1);
+        const __m256i eight = _mm256_set1_epi8(8);
+
+        __m256i columnsLow = _mm256_setzero_si256();
+        __m256i columnsHigh = _mm256_setzero_si256();
+        __m256i boxesLow = _mm256_setzero_si256();
+        __m256i boxesHigh = _mm256_setzero_si256();
+        unsigned short low[16];
+        unsigned short high[16];
+
+        unsigned int allA = ALL_DIGIT_BITS;
+        unsigned int allB = ALL_DIGIT_BITS;
+        unsigned int inRange = 0xFFFFFFFF;
+        for (int r = 0; r < 9; r++)
+        {
+            int offset = r < 8 ? 9 * r : 65;
+            __m256i v = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(gridA + offset))),
+                _mm_loadu_si128((const __m128i*)(gridB + offset)), 1);
+            if (r == 8)
+                v = _mm256_srli_si256(v, 7);
+
+            __m256i t = _mm256_sub_epi8(v, one);
+            inRange &= (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(t, eight), eight));
+
+            __m256i bytesLow = _mm256_shuffle_epi8(lutLow, v);
+            __m256i bytesHigh = _mm256_shuffle_epi8(lutHigh, v);
+            __m256i bitsLow = _mm256_unpacklo_epi8(bytesLow, bytesHigh);
+            __m256i bitsHigh = _mm256_unpackhi_epi8(bytesLow, bytesHigh);
+
+            columnsLow = _mm256_or_si256(columnsLow, bitsLow);
+            columnsHigh = _mm256_or_si256(columnsHigh, bitsHigh);
+            boxesLow = _mm256_or_si256(boxesLow, bitsLow);
+            boxesHigh = _mm256_or_si256(boxesHigh, bitsHigh);
+
+            __m256i row = bitsLow;
+            row = _mm256_or_si256(row, _mm256_srli_si256(row, 8));
+            row = _mm256_or_si256(row, _mm256_srli_si256(row, 4));
+            row = _mm256_or_si256(row, _mm256_srli_si256(row, 2));
+            row = _mm256_or_si256(row, bitsHigh);
+            allA &= (unsigned int)_mm256_extract_epi16(row, 0);
+            allB &= (unsigned int)_mm256_extract_epi16(row, 8);
+
+            if (r % 3 == 2)
+            {
+                _mm256_storeu_si256((__m256i*)low, boxesLow);
+                _mm256_storeu_si256((__m256i*)high, boxesHigh);
+                allA &= UnitMask(low, high, 0, 3) & UnitMask(low, high, 3, 3) & UnitMask(low, high, 6, 3);
+                allB &= UnitMask(low + 8, high + 8, 0, 3) & UnitMask(low + 8, high + 8, 3, 3) & UnitMask(low + 8, high + 8, 6, 3);
+                boxesLow = _mm256_setzero_si256();
+                boxesHigh = _mm256_setzero_si256();
+            }
+        }
+
+        _mm256_storeu_si256((__m256i*)low, columnsLow);
+        _mm256_storeu_si256((__m256i*)high, columnsHigh);
+        for (int j = 0; j < 9; j++)
+        {
+            allA &= UnitMask(low, high, j, 1);
+            allB &= UnitMask(low + 8, high + 8, j, 1);
+        }
+
+        results[0] = ((inRange & 0x1FF) == 0x1FF && allA == ALL_DIGIT_BITS) ? 1 : 0;
+        results[1] = (((inRange >> 16) & 0x1FF) == 0x1FF && allB == ALL_DIGIT_BITS) ? 1 : 0;
+    }
+
+    KSUDOKU_TARGET("avx2")
+    size_t ValidateGridsAVX2(const unsigned char* grids, size_t nGrids, unsigned char* results)
+    {
+        size_t nValid = 0;
+        size_t k = 0;
+        for (; k + 1 < nGrids; k += 2)
+        {
+            ValidateGridPairAVX2(grids + k * 81, grids + (k + 1) * 81, results + k);
+            nValid += results[k] + results[k + 1];
+        }
+        if (k < nGrids)
+        {
+            results[k] = ValidateGridSSSE3(grids + k * 81) ? 1 : 0;
+            nValid += results[k];
+        }
+        return nValid;
+    }
+
+    enum InstructionSet { ISA_SCALAR, ISA_SSSE3, ISA_AVX2 };
+
+    InstructionSet DetectInstructionSet()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        int nIds = info[0];
+
+        __cpuid(info, 1);
+        bool bSSSE3 = (info[2] & (1 << 9)) != 0;
+        bool bOSXSave = (info[2] & (1 << 27)) != 0;
+        bool bAVX = (info[2] & (1 << 28)) != 0;
+
+        // AVX2 also needs the OS to save the YMM registers
+        bool bAVX2 = false;
+        if (nIds >= 7 && bOSXSave && bAVX && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            bAVX2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool bSSSE3 = __builtin_cpu_supports("ssse3") != 0;
+        bool bAVX2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+        if (bAVX2 && bSSSE3)
+            return ISA_AVX2;
+        if (bSSSE3)
+            return ISA_SSSE3;
+        return ISA_SCALAR;
+    }
+
+    // the one detected, unless the tests forced a lower one
+    InstructionSet& ActiveInstructionSet()
+    {
+        static InstructionSet isa = DetectInstructionSet();
+        return isa;
+    }
+
+    InstructionSet GetInstructionSet()
+    {
+        return ActiveInstructionSet();
+    }
+
+#endif
+
+    bool ValidateGrid(const unsigned char grid[81])
+    {
+#if KSUDOKU_VALIDATOR_X86
+        if (GetInstructionSet() != ISA_SCALAR)
+            return ValidateGridSSSE3(grid);
+#endif
+        return ValidateGridScalar(grid);
+    }
+
+    size_t ValidateGrids(const unsigned char* grids, size_t nGrids, unsigned char* results)
+    {
+#if KSUDOKU_VALIDATOR_X86
+        switch (GetInstructionSet())
+        {
+        case ISA_AVX2:
+            return ValidateGridsAVX2(grids, nGrids, results);
+        case ISA_SSSE3:
+            return ValidateGridsSSSE3(grids, nGrids, results);
+        default:
+            break;
+        }
+#endif
+        return ValidateGridsScalar(grids, nGrids, results);
+    }
+
+    bool ForceValidatorInstructionSet(const char* name)
+    {
+#if KSUDOKU_VALIDATOR_X86
+        InstructionSet isa = strcmp(name, "avx2") == 0 ? ISA_AVX2
+                           : strcmp(name, "ssse3") == 0 ? ISA_SSSE3 : ISA_SCALAR;
+        if (isa != ISA_SCALAR && isa > DetectInstructionSet())
+            return false;
+        if (isa == ISA_SCALAR && strcmp(name, "scalar") != 0)
+            return false;
+        ActiveInstructionSet() = isa;
+        return true;
+#else
+        return strcmp(name, "scalar") == 0;
+#endif
+    }
+
+    const char* ValidatorInstructionSet()
+    {
+#if KSUDOKU_VALIDATOR_X86
+        switch (GetInstructionSet())
+        {
+        case ISA_AVX2:
+            return "avx2";
+        case ISA_SSSE3:
+            return "ssse3";
+        default:
+            break;
+        }
+#endif
+        return "scalar";
+    }
+
+}
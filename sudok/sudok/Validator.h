@@ -0,0 +1,22 @@
+#pragma once
+#include <stddef.h>
+
+namespace KSudoku {
+
+    // A grid is 81 bytes row by row, each the digit 1 ~ 9 of a cell (not the character '1' ~ '9').
+
+    // true if every row, column and sub-region of the grid holds the digits 1 ~ 9 once
+    bool ValidateGrid(const unsigned char grid[81]);
+
+    // validates nGrids grids stored back to back, results[k] is set to 1 if grid k is valid,
+    // 0 otherwise. Returns the number of valid grids.
+    size_t ValidateGrids(const unsigned char* grids, size_t nGrids, unsigned char* results);
+
+    // the instruction set picked at runtime: "avx2", "ssse3" or "scalar"
+    const char* ValidatorInstructionSet();
+
+    // Makes the validator use "avx2", "ssse3" or "scalar" from now on rather than the best the CPU
+    // has, for the tests to compare the paths. False if the CPU lacks it. Not to be called while
+    // another thread validates.
+    bool ForceValidatorInstructionSet(const char* name);
+}
@@ -0,0 +1,302 @@
+// -----------------------------------------------------------------------------
+//
+// Runs every solver over the puzzle corpora and reports the latency per puzzle.
+//
+// Usage: ksudoku_bench [--corpus dir] [--engines mrv,dlx,...] [--corpora easy,hard,...]
+//                      [--repeat N] [--threads N] [--propagate] [--json results.json]
+//
+// A corpus is a text file of puzzles in the batch mode format, in the corpus
+// directory: easy.txt, hard.txt, 17clue.txt and adversarial.txt. Each puzzle is timed from
+// loading the board to the end of the search and the solution is verified. The engines run
+// on the bare puzzle, with --propagate the singles are filled first like the command line
+// tool does, which solves most easy puzzles before any engine starts.
+//
+// For every engine and corpus the median, p99 and max latency, the puzzles per second and
+// the search nodes per puzzle are printed as a table, and written as JSON if asked.
+//
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Board.h"
+#include "SearchStats.h"
+#include "PuzzleFile.h"
+#include "Propagation.h"
+#include "BackTracking.h"
+#include "BitMask.h"
+#include "MRV.h"
+#include "DLX.h"
+#include "Permutation.h"
+#include "ParallelSearch.h"
+#include "ThreadPool.h"
+
+#ifndef KSUDOKU_CORPUS_DIR
+#define KSUDOKU_CORPUS_DIR "benchmark/corpus"
+#endif
+
+using namespace KSudoku;
+
+namespace {
+
+    int g_nThreads = 1;             // for the parallel engine
+    bool g_bPropagate = false;      // fill the singles before the engine runs
+
+    bool BenchBackTracking(Board& board, SearchStats* pStats)  { return SearchBackTracking(board, nullptr, pStats); }
+    bool BenchBitMask(Board& board, SearchStats* pStats)       { return SearchBitMask(board, nullptr, pStats); }
+    bool BenchMRV(Board& board, SearchStats* pStats)           { return SearchMRV(board, nullptr, pStats); }
+    bool BenchDLX(Board& board, SearchStats* pStats)           { return SearchDLX(board, nullptr, pStats); }
+    bool BenchPermutation(Board& board, SearchStats* pStats)   { return SearchPermutation(board, nullptr, pStats); }
+    bool BenchParallel(Board& board, SearchStats* pStats)      { return SearchParallel(board, g_nThreads, nullptr, pStats); }
+
+    struct Engine {
+        const char* name;
+        bool        (*search)(Board& board, SearchStats* pStats);
+    };
+
+    const Engine ENGINES[] = {
+        { "backtracking",   BenchBackTracking },
+        { "bitmask",        BenchBitMask },
+        { "mrv",            BenchMRV },
+        { "dlx",            BenchDLX },
+        { "permutation",    BenchPermutation },
+        { "parallel",       BenchParallel },
+    };
+
+    const char* const CORPORA[] = { "easy", "hard", "17clue", "adversarial" };
+
+    struct Puzzle {
+        char cells[81];
+    };
+
+    struct Result {
+        std::string         engine;
+        std::string         corpus;
+        long long           nPuzzles;
+        long long           nSolved;
+        double              medianUs;
+        double              p99Us;
+        double              maxUs;
+        double              puzzlesPerSecond;
+        double              nodesPerPuzzle;
+    };
+
+    // true if name is in the comma separated list, an empty list holds everything
+    bool IsListed(const std::string& list, const char* name)
+    {
+        if (list.empty())
+            return true;
+
+        std::string padded = "," + list + ",";
+        return padded.find("," + std::string(name) + ",") != std::string::npos;
+    }
+
+    bool LoadCorpus(const std::string& fileName, std::vector<Puzzle>& puzzles)
+    {
+        MappedFile file;
+        if (!file.open(fileName.c_str()))
+            return false;
+
+        PuzzleParser parser(file.begin(), file.end());
+        Puzzle puzzle;
+        ParseResult result;
+        while ((result = parser.next(puzzle.cells)) != PARSE_END)
+        {
+            if (result == PARSE_PUZZLE)
+                puzzles.push_back(puzzle);
+            else
+                fprintf(stderr, "%s line %lld: invalid puzzle, %s, skipped\n", fileName.c_str(), parser.recordLine(), parser.error());
+        }
+
+        return true;
+    }
+
+    // the solution is complete, valid and keeps every given of the puzzle
+    bool IsSolutionOf(const Board& board, const Puzzle& puzzle)
+    {
+        if (!VerifySolution(board))
+            return false;
+
+        for (int n = 0; n < 81; n++)
+        {
+            if (puzzle.cells[n] != 0 && board.value(n) != puzzle.cells[n])
+                return false;
+        }
+
+        return true;
+    }
+
+    // the value below which the given share of the sorted samples lie, nearest rank
+    double Percentile(const std::vector<double>& sorted, double share)
+    {
+        if (sorted.empty())
+            return 0;
+
+        size_t rank = (size_t)(share * sorted.size() + 0.999999);
+        if (rank < 1)
+            rank = 1;
+        if (rank > sorted.size())
+            rank = sorted.size();
+        return sorted[rank - 1];
+    }
+
+    Result RunEngine(const Engine& engine, const char* corpus, const std::vector<Puzzle>& puzzles, int nRepeat)
+    {
+        Board board;
+        SearchStats stats;
+        std::vector<double> latencies;
+        latencies.reserve(puzzles.size() * nRepeat);
+
+        long long nSolved = 0;
+        double totalSeconds = 0;
+        for (int r = 0; r < nRepeat; r++)
+        {
+            for (size_t k = 0; k < puzzles.size(); k++)
+            {
+                const Puzzle& puzzle = puzzles[k];
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                bool b = LoadBoard(board, puzzle.cells) && (!g_bPropagate || Propagate(board)) && engine.search(board, &stats);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                if (b && IsSolutionOf(board, puzzle))
+                    nSolved++;
+                latencies.push_back(seconds * 1e6);
+                totalSeconds += seconds;
+            }
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        Result result;
+        result.engine = engine.name;
+        result.corpus = corpus;
+        result.nPuzzles = (long long)latencies.size();
+        result.nSolved = nSolved;
+        result.medianUs = Percentile(latencies, 0.5);
+        result.p99Us = Percentile(latencies, 0.99);
+        result.maxUs = latencies.empty() ? 0 : latencies.back();
+        result.puzzlesPerSecond = totalSeconds > 0 ? latencies.size() / totalSeconds : 0;
+        result.nodesPerPuzzle = latencies.empty() ? 0 : (double)stats.nNodes / latencies.size();
+        return result;
+    }
+
+    void PrintHeader()
+    {
+        printf("%-14s %-12s %8s %8s %12s %12s %12s %12s %14s\n",
+            "engine", "corpus", "puzzles", "solved", "median us", "p99 us", "max us", "puzzles/s", "nodes/puzzle");
+    }
+
+    void PrintResult(const Result& r)
+    {
+        printf("%-14s %-12s %8lld %8lld %12.1f %12.1f %12.1f %12.0f %14.1f\n",
+            r.engine.c_str(), r.corpus.c_str(), r.nPuzzles, r.nSolved,
+            r.medianUs, r.p99Us, r.maxUs, r.puzzlesPerSecond, r.nodesPerPuzzle);
+        fflush(stdout);
+    }
+
+    bool WriteJson(const char* fileName, const std::vector<Result>& results, int nRepeat)
+    {
+        FILE* file = fopen(fileName, "w");
+        if (!file)
+            return false;
+
+        fprintf(file, "{\n  \"repeat\": %d,\n  \"threads\": %d,\n  \"propagate\": %s,\n  \"results\": [",
+            nRepeat, g_nThreads, g_bPropagate ? "true" : "false");
+        for (size_t k = 0; k < results.size(); k++)
+        {
+            const Result& r = results[k];
+            fprintf(file, "%s\n    {\"engine\": \"%s\", \"corpus\": \"%s\", \"puzzles\": %lld, \"solved\": %lld, "
+                "\"median_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f, \"puzzles_per_second\": %.1f, "
+                "\"nodes_per_puzzle\": %.1f}",
+                k == 0 ? "" : ",", r.engine.c_str(), r.corpus.c_str(), r.nPuzzles, r.nSolved,
+                r.medianUs, r.p99Us, r.maxUs, r.puzzlesPerSecond, r.nodesPerPuzzle);
+        }
+        fprintf(file, "\n  ]\n}\n");
+
+        fclose(file);
+        return true;
+    }
+
+}
+
+int _tmain(int argc, char* argv[])
+{
+    std::string corpusDir = KSUDOKU_CORPUS_DIR;
+    std::string engines;
+    std::string corpora;
+    const char* jsonFileName = NULL;
+    int nRepeat = 1;
+    g_nThreads = WorkStealingPool::defaultThreadCount();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc)
+            corpusDir = argv[++i];
+        else if (strcmp(argv[i], "--engines") == 0 && i + 1 < argc)
+            engines = argv[++i];
+        else if (strcmp(argv[i], "--corpora") == 0 && i + 1 < argc)
+            corpora = argv[++i];
+        else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+            nRepeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            g_nThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--propagate") == 0)
+            g_bPropagate = true;
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonFileName = argv[++i];
+        else
+        {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return -1;
+        }
+    }
+    if (nRepeat < 1)
+        nRepeat = 1;
+
+    // load all the corpora up front, the parsing is not timed
+    std::vector<std::vector<Puzzle> > puzzles(sizeof(CORPORA) / sizeof(CORPORA[0]));
+    for (size_t c = 0; c < puzzles.size(); c++)
+    {
+        if (!IsListed(corpora, CORPORA[c]))
+            continue;
+
+        std::string fileName = corpusDir + "/" + CORPORA[c] + ".txt";
+        if (!LoadCorpus(fileName, puzzles[c]))
+        {
+            fprintf(stderr, "can't open %s\n", fileName.c_str());
+            return -1;
+        }
+    }
+
+    std::vector<Result> results;
+    PrintHeader();
+    for (size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); e++)
+    {
+        if (!IsListed(engines, ENGINES[e].name))
+            continue;
+
+        for (size_t c = 0; c < puzzles.size(); c++)
+        {
+            if (puzzles[c].empty())
+                continue;
+
+            results.push_back(RunEngine(ENGINES[e], CORPORA[c], puzzles[c], nRepeat));
+            PrintResult(results.back());
+        }
+    }
+
+    if (jsonFileName && !WriteJson(jsonFileName, results, nRepeat))
+    {
+        fprintf(stderr, "can't open %s\n", jsonFileName);
+        return -1;
+    }
+
+    long long nFailed = 0;
+    for (size_t k = 0; k < results.size(); k++)
+        nFailed += results[k].nPuzzles - results[k].nSolved;
+    return nFailed == 0 ? 0 : -1;
+}
@@ -5,10 +5,16 @@
 
 #pragma once
 
+#ifdef _WIN32
 #include "targetver.h"
+#include <tchar.h>
+#else
+// gcc and clang builds, see CMakeLists.txt
+#define _tmain      main
+#endif
 
 #include <stdio.h>
-#include <tchar.h>
+#include <string.h>
 
 
 
@@ -0,0 +1,248 @@
+// Packs puzzles and solutions into archives, compressed or not, and checks that unpacking gives
+// back the same text byte for byte, that truncated or corrupted archives are rejected, and
+// that a failed write stops the packing.
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "Archive.h"
+#include "BlockCompressor.h"
+#include "Check.h"
+#include "TestGrids.h"
+
+using namespace KSudoku;
+using namespace KSudokuTest;
+
+bool WriteFile(const char* fileName, const std::string& bytes)
+{
+    FILE* file = fopen(fileName, "wb");
+    if (!file)
+        return false;
+    bool bWritten = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && bWritten;
+}
+
+std::string ReadFile(const char* fileName)
+{
+    std::string bytes;
+    FILE* file = fopen(fileName, "rb");
+    if (!file)
+        return bytes;
+    char buffer[1 << 16];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes.append(buffer, n);
+    fclose(file);
+    return bytes;
+}
+
+std::string GridLine(const char grid[81])
+{
+    std::string line(81, '.');
+    for (int n = 0; n < 81; n++)
+    {
+        if (grid[n] != 0)
+            line[n] = (char)('0' + grid[n]);
+    }
+    return line + "\n";
+}
+
+// Three blocks and a bit of puzzles and of their solutions, in the text the unpacking writes.
+// The grids come back every few hundred lines so the compressed blocks do shrink, and there are
+// an empty puzzle, a full one and some "no solution" lines.
+void MakeTexts(std::string& puzzles, std::string& solutions)
+{
+    std::mt19937 random(418);
+    std::vector<std::string> puzzleLines;
+    std::vector<std::string> solutionLines;
+    for (int k = 0; k < 300; k++)
+    {
+        char grid[81];
+        RandomValidGrid(random, grid);
+        solutionLines.push_back(k % 37 == 5 ? "no solution\n" : GridLine(grid));
+
+        // the first puzzle is empty, the second full
+        int nGiven = k == 0 ? 0 : 17 + (int)(random() % 30);
+        for (int n = 0; n < 81 && k != 1; n++)
+        {
+            if ((int)(random() % 81) >= nGiven)
+                grid[n] = 0;
+        }
+        puzzleLines.push_back(GridLine(grid));
+    }
+
+    for (int k = 0; k < 3 * ARCHIVE_BLOCK_RECORDS + 123; k++)
+    {
+        puzzles += puzzleLines[k % puzzleLines.size()];
+        solutions += solutionLines[k % solutionLines.size()];
+    }
+}
+
+void CheckRoundTrip(const std::string& text, ArchiveKind kind, bool bCompress, std::string& archive)
+{
+    const char* textName = "archive_test.txt";
+    const char* archiveName = "archive_test.ksa";
+    const char* unpackedName = "archive_test_unpacked.txt";
+    CHECK(WriteFile(textName, text));
+    CHECK(PackArchive(textName, archiveName, kind, bCompress) == 0);
+    CHECK(UnpackArchive(archiveName, unpackedName) == 0);
+    CHECK(ReadFile(unpackedName) == text);
+
+    archive = ReadFile(archiveName);
+    CHECK(archive.size() > (size_t)ARCHIVE_HEADER_SIZE);
+    CHECK(archive.size() < text.size());
+    remove(textName);
+    remove(unpackedName);
+}
+
+bool Unpacks(const std::string& archive)
+{
+    const char* archiveName = "archive_test_corrupt.ksa";
+    const char* unpackedName = "archive_test_corrupt.txt";
+    CHECK(WriteFile(archiveName, archive));
+    int nResult = UnpackArchive(archiveName, unpackedName);
+    remove(archiveName);
+    remove(unpackedName);
+    return nResult == 0;
+}
+
+void PutU32(std::string& bytes, size_t at, unsigned int v)
+{
+    for (int k = 0; k < 4; k++)
+        bytes[at + k] = (char)(v >> (8 * k));
+}
+
+unsigned long long GetLittleEndian(const std::string& bytes, size_t at, int nBytes)
+{
+    unsigned long long v = 0;
+    for (int k = nBytes - 1; k >= 0; k--)
+        v = v << 8 | (unsigned char)bytes[at + k];
+    return v;
+}
+
+void CheckCorruptions(const std::string& archive, ArchiveKind kind, bool bCompress)
+{
+    CHECK(Unpacks(archive));
+
+    size_t truncated[] = { 0, 3, ARCHIVE_HEADER_SIZE - 1, ARCHIVE_HEADER_SIZE, archive.size() / 2, archive.size() - 1 };
+    for (size_t k = 0; k < sizeof(truncated) / sizeof(truncated[0]); k++)
+        CHECK(!Unpacks(archive.substr(0, truncated[k])));
+
+    // the header and the index entry of the first block
+    size_t nIndex = (size_t)GetLittleEndian(archive, 24, 8);
+    size_t nBlock = (size_t)GetLittleEndian(archive, nIndex, 8);
+    unsigned int nStored = (unsigned int)GetLittleEndian(archive, nIndex + 8, 4);
+    unsigned int nRaw = (unsigned int)GetLittleEndian(archive, nIndex + 12, 4);
+    CHECK(nBlock == (size_t)ARCHIVE_HEADER_SIZE);
+    CHECK(bCompress ? nStored < nRaw : nStored == nRaw);
+
+    std::string bad = archive;
+    bad[0] = 'X';                                   // not an archive
+    CHECK(!Unpacks(bad));
+
+    bad = archive;
+    bad[4] = 2;                                     // an unknown version
+    CHECK(!Unpacks(bad));
+
+    bad = archive;
+    bad[6] = 7;                                     // an unknown kind
+    CHECK(!Unpacks(bad));
+
+    bad = archive;
+    bad[16]++;                                      // one record more than the blocks hold
+    CHECK(!Unpacks(bad));
+
+    bad = archive;
+    bad[24]++;                                      // the index moved
+    CHECK(!Unpacks(bad));
+
+    bad = archive;
+    PutU32(bad, nIndex, (unsigned int)nIndex);      // the first block where the index is
+    CHECK(!Unpacks(bad));
+
+    bad = archive;
+    PutU32(bad, nIndex + 12, nRaw + 1);             // the raw size of the first block
+    CHECK(!Unpacks(bad));
+
+    if (bCompress)
+    {
+        bad = archive;
+        PutU32(bad, nIndex + 8, nStored / 2);       // the compressed block cut short
+        CHECK(!Unpacks(bad));
+
+        bad = archive;
+        for (size_t n = nBlock; n < nBlock + nStored; n++)
+            bad[n] = (char)0xFF;                    // lengths running past the block
+        CHECK(!Unpacks(bad));
+    }
+    else if (kind == ARCHIVE_PUZZLES)
+    {
+        // the first record is the empty puzzle, a bitmap alone, the second a full one: its
+        // first two digits become 0
+        bad = archive;
+        CHECK(bad[nBlock] == 0 && (unsigned char)bad[nBlock + 11] == 0xFF);
+        bad[nBlock + 11 + 11] = 0;
+        CHECK(!Unpacks(bad));
+    }
+    else
+    {
+        bad = archive;
+        bad[nBlock] = (char)0xA9;                   // 9 ^ 5, too big for five digits
+        bad[nBlock + 1] = (char)0xE6;
+        CHECK(!Unpacks(bad));
+    }
+}
+
+void CheckCompressor()
+{
+    std::mt19937 random(7);
+    for (size_t nSize = 1; nSize < 2000; nSize += 1 + nSize / 3)
+    {
+        // runs of a few bytes, so there are matches of every length and offset
+        std::vector<unsigned char> raw(nSize);
+        for (size_t n = 0; n < nSize; n++)
+            raw[n] = n >= 8 && random() % 4 != 0 ? raw[n - 1 - random() % 8] : (unsigned char)random();
+
+        std::vector<unsigned char> compressed(CompressBound(nSize));
+        size_t nCompressed = CompressBlock(raw.data(), nSize, compressed.data(), compressed.size());
+        CHECK(nCompressed > 0);
+
+        std::vector<unsigned char> back(nSize + 1);
+        CHECK(DecompressBlock(compressed.data(), nCompressed, back.data(), back.size()) == (long long)nSize);
+        CHECK(std::equal(raw.begin(), raw.end(), back.begin()));
+        CHECK(DecompressBlock(compressed.data(), nCompressed, back.data(), nSize - 1) < 0);
+    }
+}
+
+int main()
+{
+    std::string puzzles;
+    std::string solutions;
+    MakeTexts(puzzles, solutions);
+
+    for (int k = 0; k < 4; k++)
+    {
+        ArchiveKind kind = k < 2 ? ARCHIVE_PUZZLES : ARCHIVE_SOLUTIONS;
+        bool bCompress = k % 2 == 1;
+        std::string archive;
+        CheckRoundTrip(kind == ARCHIVE_PUZZLES ? puzzles : solutions, kind, bCompress, archive);
+        CheckCorruptions(archive, kind, bCompress);
+        printf("%s%s: %zu bytes, round trip and corruptions checked\n",
+            kind == ARCHIVE_PUZZLES ? "puzzles" : "solutions", bCompress ? " compressed" : "", archive.size());
+    }
+    remove("archive_test.ksa");
+
+    CheckCompressor();
+
+#ifdef __linux__
+    // every write to /dev/full fails, the packing has to give up
+    CHECK(WriteFile("archive_test.txt", puzzles));
+    CHECK(PackArchive("archive_test.txt", "/dev/full", ARCHIVE_PUZZLES, false) == -1);
+    remove("archive_test.txt");
+#endif
+
+    return TestResult();
+}
@@ -0,0 +1,158 @@
+// Checks what the solution cache relies on, on random symmetries of the puzzles of the benchmark
+// corpora: a transform and its inverse give back the grid, every symmetry of a puzzle has the
+// same canonical form, and a solution taken from the cache for a symmetry solves the puzzle
+// with its givens. Nearly empty grids, whose forms may differ, must still get right answers.
+
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "Canonical.h"
+#include "PuzzleFile.h"
+#include "SolutionCache.h"
+#include "Solver.h"
+#include "Validator.h"
+#include "Check.h"
+#include "TestGrids.h"
+
+#ifndef KSUDOKU_CORPUS_DIR
+#define KSUDOKU_CORPUS_DIR "benchmark/corpus"
+#endif
+
+using namespace KSudoku;
+using namespace KSudokuTest;
+
+struct Puzzle {
+    char cells[81];
+};
+
+void ReadCorpus(const char* name, std::vector<Puzzle>& puzzles)
+{
+    std::string fileName = std::string(KSUDOKU_CORPUS_DIR "/") + name + ".txt";
+    MappedFile file;
+    CHECK(file.open(fileName.c_str()));
+
+    PuzzleParser parser(file.begin(), file.end());
+    Puzzle puzzle;
+    ParseResult result;
+    while ((result = parser.next(puzzle.cells)) != PARSE_END)
+    {
+        CHECK(result == PARSE_PUZZLE);
+        puzzles.push_back(puzzle);
+    }
+}
+
+// the solution is full and valid and keeps every given of the puzzle
+bool Solves(const char solution[81], const char puzzle[81])
+{
+    unsigned char grid[81];
+    for (int n = 0; n < 81; n++)
+    {
+        if (puzzle[n] != 0 && solution[n] != puzzle[n])
+            return false;
+        grid[n] = (unsigned char)solution[n];
+    }
+    return ValidateGrid(grid);
+}
+
+void CheckSymmetries(const std::vector<Puzzle>& puzzles, int nSymmetries, SolutionCache& cache)
+{
+    std::mt19937 random(2014);
+    for (size_t k = 0; k < puzzles.size(); k++)
+    {
+        const char* puzzle = puzzles[k].cells;
+        char canonical[81];
+        GridTransform canonicalTransform;
+        CanonicalizeGrid(puzzle, canonical, canonicalTransform);
+
+        char grid[81];
+        TransformGrid(canonicalTransform, puzzle, grid);
+        CHECK(memcmp(grid, canonical, 81) == 0);
+
+        for (int s = 0; s < nSymmetries; s++)
+        {
+            GridTransform transform;
+            RandomGridTransform(random, transform);
+            char symmetric[81];
+            char back[81];
+            TransformGrid(transform, puzzle, symmetric);
+            UntransformGrid(transform, symmetric, back);
+            CHECK(memcmp(back, puzzle, 81) == 0);
+
+            char symmetricCanonical[81];
+            GridTransform symmetricTransform;
+            CanonicalizeGrid(symmetric, symmetricCanonical, symmetricTransform);
+            CHECK(memcmp(symmetricCanonical, canonical, 81) == 0);
+
+            char solution[81];
+            CHECK(SolveGridCached(cache, symmetric, solution, NULL, NULL) == SOLVE_SOLVED);
+            CHECK(Solves(solution, symmetric));
+        }
+
+        // by now its canonical form is cached, a hit mapped back to the puzzle itself
+        char solution[81];
+        unsigned long long nHits = cache.hits();
+        CHECK(SolveGridCached(cache, puzzle, solution, NULL, NULL) == SOLVE_SOLVED);
+        CHECK(cache.hits() == nHits + 1);
+        CHECK(Solves(solution, puzzle));
+    }
+}
+
+// An empty grid and grids of a few clues have too many symmetries to keep them all, their forms
+// may differ from one symmetry to another but any hit must still solve the grid asked.
+void CheckSparseGrids(SolutionCache& cache)
+{
+    std::mt19937 random(19);
+    for (int nClues = 0; nClues <= 4; nClues++)
+    {
+        char full[81];
+        RandomValidGrid(random, full);
+        char puzzle[81] = {};
+        for (int k = 0; k < nClues; k++)
+        {
+            int n = (int)(random() % 81);
+            puzzle[n] = full[n];
+        }
+
+        for (int s = 0; s < 20; s++)
+        {
+            GridTransform transform;
+            RandomGridTransform(random, transform);
+            char symmetric[81];
+            char back[81];
+            TransformGrid(transform, puzzle, symmetric);
+            UntransformGrid(transform, symmetric, back);
+            CHECK(memcmp(back, puzzle, 81) == 0);
+
+            // the form is a symmetry of the grid, whichever it is
+            char canonical[81];
+            GridTransform canonicalTransform;
+            CanonicalizeGrid(symmetric, canonical, canonicalTransform);
+            TransformGrid(canonicalTransform, symmetric, back);
+            CHECK(memcmp(back, canonical, 81) == 0);
+
+            char solution[81];
+            CHECK(SolveGridCached(cache, symmetric, solution, NULL, NULL) == SOLVE_SOLVED);
+            CHECK(Solves(solution, symmetric));
+        }
+    }
+}
+
+int main()
+{
+    const char* CORPORA[] = { "easy", "hard", "17clue", "adversarial" };
+    SolutionCache cache(100000, 4);
+    size_t nPuzzles = 0;
+    for (size_t k = 0; k < sizeof(CORPORA) / sizeof(CORPORA[0]); k++)
+    {
+        std::vector<Puzzle> puzzles;
+        ReadCorpus(CORPORA[k], puzzles);
+        CheckSymmetries(puzzles, 20, cache);
+        nPuzzles += puzzles.size();
+    }
+    printf("%zu puzzles, 20 symmetries each, %llu hits and %llu misses\n", nPuzzles, cache.hits(), cache.misses());
+
+    CheckSparseGrids(cache);
+
+    return TestResult();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdio.h>
+
+// The checks of the test programs: a failed one is reported with its line and the test goes on,
+// main returns TestResult(), 1 if any failed.
+//
+namespace KSudokuTest {
+
+    inline int& Failures()
+    {
+        static int nFailures = 0;
+        return nFailures;
+    }
+
+    inline int TestResult()
+    {
+        if (Failures() > 0)
+            fprintf(stderr, "%d checks failed\n", Failures());
+        return Failures() > 0 ? 1 : 0;
+    }
+
+}
+
+#define CHECK(condition)                                                                    \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);   \
+            KSudokuTest::Failures()++;                                                      \
+        }                                                                                   \
+    } while (0)
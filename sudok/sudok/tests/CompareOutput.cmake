@@ -0,0 +1,11 @@
+# Runs a ksudoku mode on an input file and compares what it writes with the expected file.
+#
+#   cmake -DKSUDOKU=... -DMODE=batch -DINPUT=... -DEXPECTED=... -DOUTPUT=... -P CompareOutput.cmake
+
+execute_process(COMMAND ${KSUDOKU} ${INPUT} ${MODE} ${OUTPUT} --threads 1
+                RESULT_VARIABLE result ERROR_VARIABLE errors)
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED} RESULT_VARIABLE different)
+if(different)
+    file(READ ${OUTPUT} output)
+    message(FATAL_ERROR "${INPUT} ${MODE}:\n${errors}\nwrote:\n${output}")
+endif()
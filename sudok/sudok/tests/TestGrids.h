@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <random>
+#include "Canonical.h"
+
+// Random grids for the test programs, the same on every run for a given seed.
+//
+namespace KSudokuTest {
+
+    // shuffles 0 ~ 8 keeping the bands of three together: the bands, then the lines within each
+    inline void ShuffleLines(std::mt19937& random, unsigned char lines[9])
+    {
+        unsigned char bands[3] = { 0, 1, 2 };
+        std::shuffle(bands, bands + 3, random);
+        for (int b = 0; b < 3; b++)
+        {
+            unsigned char inner[3] = { 0, 1, 2 };
+            std::shuffle(inner, inner + 3, random);
+            for (int i = 0; i < 3; i++)
+                lines[b * 3 + i] = (unsigned char)(bands[b] * 3 + inner[i]);
+        }
+    }
+
+    // a random valid grid, the cells 1 ~ 9 row by row: a fixed one with its digits relabeled and
+    // its rows, bands, columns and stacks shuffled
+    template <typename Cell>
+    void RandomValidGrid(std::mt19937& random, Cell grid[81])
+    {
+        int digits[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        std::shuffle(digits, digits + 9, random);
+
+        unsigned char rows[9];
+        unsigned char columns[9];
+        ShuffleLines(random, rows);
+        ShuffleLines(random, columns);
+        for (int i = 0; i < 9; i++)
+        {
+            for (int j = 0; j < 9; j++)
+                grid[i * 9 + j] = (Cell)digits[(rows[i] * 3 + rows[i] / 3 + columns[j]) % 9];
+        }
+    }
+
+    // a random symmetry: maybe a transposition, the rows and columns shuffled by bands and the
+    // digits relabeled
+    inline void RandomGridTransform(std::mt19937& random, KSudoku::GridTransform& transform)
+    {
+        transform.bTranspose = random() % 2 == 1;
+        ShuffleLines(random, transform.rows);
+        ShuffleLines(random, transform.columns);
+        for (int v = 0; v <= 9; v++)
+            transform.digits[v] = (unsigned char)v;
+        std::shuffle(transform.digits + 1, transform.digits + 10, random);
+    }
+
+}
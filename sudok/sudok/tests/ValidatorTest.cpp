@@ -0,0 +1,100 @@
+// Compares every SIMD path of the validator the CPU has with the scalar one, on valid grids,
+// grids with one cell changed and grids with bytes out of 1 ~ 9, in batches of every size up
+// to a few dozen so the odd grid left by the two grids at a time of AVX2 is covered.
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "Validator.h"
+#include "Check.h"
+#include "TestGrids.h"
+
+using namespace KSudoku;
+using namespace KSudokuTest;
+
+// valid grids, then each of them broken in one way, in the order they were made
+void MakeGrids(std::vector<unsigned char>& grids, std::vector<unsigned char>& expected)
+{
+    // bytes out of range, some of them equal to a digit in their low bits
+    static const unsigned char OUT_OF_RANGE[] = { 0, 10, 11, 15, 16, 17, 25, 33, 65, 127, 128, 129, 137, 200, 255 };
+
+    std::mt19937 random(20140419);
+    unsigned char grid[81];
+    for (int k = 0; k < 400; k++)
+    {
+        RandomValidGrid(random, grid);
+        grids.insert(grids.end(), grid, grid + 81);
+        expected.push_back(1);
+
+        // one cell changed to another digit, which repeats it in its row, column and sub-region
+        unsigned char changed[81];
+        memcpy(changed, grid, 81);
+        int n = (int)(random() % 81);
+        changed[n] = (unsigned char)((changed[n] + random() % 8) % 9 + 1);
+        grids.insert(grids.end(), changed, changed + 81);
+        expected.push_back(0);
+
+        memcpy(changed, grid, 81);
+        changed[random() % 81] = OUT_OF_RANGE[random() % sizeof(OUT_OF_RANGE)];
+        grids.insert(grids.end(), changed, changed + 81);
+        expected.push_back(0);
+    }
+
+    // every row 1 ~ 9 in order, so the rows are right and every column holds one digit nine times
+    for (int i = 0; i < 81; i++)
+        grid[i] = (unsigned char)(i % 9 + 1);
+    grids.insert(grids.end(), grid, grid + 81);
+    expected.push_back(0);
+}
+
+void CheckPath(const char* name, const std::vector<unsigned char>& grids, const std::vector<unsigned char>& expected)
+{
+    if (!ForceValidatorInstructionSet(name))
+    {
+        printf("%-8s not supported by this CPU, skipped\n", name);
+        return;
+    }
+    CHECK(strcmp(ValidatorInstructionSet(), name) == 0);
+
+    size_t nGrids = expected.size();
+    for (size_t k = 0; k < nGrids; k++)
+        CHECK(ValidateGrid(&grids[k * 81]) == (expected[k] != 0));
+
+    // every batch size from 1 to 40 at a few offsets, and all the grids at once
+    std::vector<unsigned char> results(nGrids + 1);
+    for (size_t nBatch = 1; nBatch <= 40; nBatch++)
+    {
+        for (size_t first = 0; first + nBatch <= nGrids; first += 37)
+        {
+            size_t nValid = 0;
+            for (size_t k = first; k < first + nBatch; k++)
+                nValid += expected[k];
+
+            std::fill(results.begin(), results.end(), 0xCC);
+            CHECK(ValidateGrids(&grids[first * 81], nBatch, &results[0]) == nValid);
+            CHECK(std::equal(results.begin(), results.begin() + nBatch, expected.begin() + first));
+            CHECK(results[nBatch] == 0xCC);     // nothing written past the batch
+        }
+    }
+
+    size_t nValid = 0;
+    for (size_t k = 0; k < nGrids; k++)
+        nValid += expected[k];
+    CHECK(ValidateGrids(&grids[0], nGrids, &results[0]) == nValid);
+    CHECK(std::equal(results.begin(), results.begin() + nGrids, expected.begin()));
+
+    printf("%-8s %zu grids checked\n", name, nGrids);
+}
+
+int main()
+{
+    std::vector<unsigned char> grids;
+    std::vector<unsigned char> expected;
+    MakeGrids(grids, expected);
+
+    CheckPath("scalar", grids, expected);
+    CheckPath("ssse3", grids, expected);
+    CheckPath("avx2", grids, expected);
+
+    return KSudokuTest::TestResult();
+}